@@ -16,6 +16,8 @@ Also defined in module scope are the constants DEFAULT, PUBLIC, PROTECTED and
 PRIVATE.
 """
 
+import weakref
+
 # Accessibility constants
 DEFAULT = 0
 PUBLIC = 1
@@ -81,6 +83,8 @@ class BuiltinTypeId(NamedTypeId):
 
     def __init__(self, language, name):
         super(BuiltinTypeId, self).__init__(language, name)
+    def __reduce__(self):
+        return _unpickle_type_id, (type(self), self.language, self.name)
     def accept(self, visitor): visitor.visit_builtin_type_id(self)
     def __cmp__(self, other):
         "Comparison operator"
@@ -92,6 +96,8 @@ class DependentTypeId(NamedTypeId):
 
     def __init__(self, language, name):
         super(DependentTypeId, self).__init__(language, name)
+    def __reduce__(self):
+        return _unpickle_type_id, (type(self), self.language, self.name)
     def accept(self, visitor): visitor.visit_dependent_type_id(self)
     def __cmp__(self, other):
         "Comparison operator"
@@ -210,22 +216,175 @@ class FunctionTypeId(TypeId):
         self.parameters = parameters
 
     def accept(self, visitor): visitor.visit_function_type_id(self)
+
+_type_ids = weakref.WeakValueDictionary()
+"""Map the keys of interned type-ids to the type-ids, as long as they are
+in use. A modifier or array type-id keeps its alias alive, so the alias'
+id can't be reused while it is part of a key. That is why their aliases
+must never be changed (see `rename_type_id` for names)."""
+
+def intern_type_id(type_id):
+    """Return the type-id equal to 'type_id' that was interned before, or
+    intern 'type_id' itself. Only builtin, dependent, modifier and array
+    type-ids are interned, as others are modified while the IR is
+    processed. Modifier and array type-ids are equal if their aliases are
+    the same object, so they are best interned bottom-up."""
+
+    t = type(type_id)
+    if t is BuiltinTypeId or t is DependentTypeId:
+        key = (t, type_id.language, type_id.name)
+    elif t is ModifierTypeId:
+        key = (t, type_id.language, id(type_id.alias),
+               tuple(type_id.premod), tuple(type_id.postmod))
+    elif t is ArrayTypeId:
+        key = (t, type_id.language, id(type_id.alias), tuple(type_id.sizes))
+    else:
+        return type_id
+    interned = _type_ids.get(key)
+    if interned is None:
+        interned = _type_ids[key] = type_id
+    return interned
+
+def rename_type_id(type_id, name):
+    """Return 'type_id' with its name changed to 'name'. Interned type-ids
+    may be shared with other parts of the IR, so rather than being renamed
+    they are replaced by (interned) new ones."""
+
+    t = type(type_id)
+    if t is BuiltinTypeId or t is DependentTypeId:
+        return intern_type_id(t(type_id.language, name))
+    type_id.name = name
+    return type_id
+
+def _unpickle_type_id(type, language, name):
+
+    return intern_type_id(type(language, name))
    
 
 class Dictionary(dict):
-    """Dictionary extends the builtin 'dict' by adding a lookup method to it."""
+    """Dictionary extends the builtin 'dict' by adding a lookup method to it.
+
+    Lookups use an index of the qualified names in the dictionary, built
+    on first use: a tree with a node per scope, mapping the next name
+    component to the nested node. Each node also holds the key ending at
+    it, if any. The index, as well as the cache of resolved names, is
+    dropped whenever a key is added or removed."""
+
+    _index = None
+    _resolved = None
+
+    def __getstate__(self):
+        """Don't pickle the index."""
+
+        state = self.__dict__.copy()
+        state.pop('_index', None)
+        state.pop('_resolved', None)
+        return state
+
+    def _invalidate(self):
+
+        self._index = None
+        self._resolved = None
+
+    def __setitem__(self, key, value):
+
+        if self._index is not None and not dict.__contains__(self, key):
+            self._invalidate()
+        dict.__setitem__(self, key, value)
+
+    def __delitem__(self, key):
+
+        self._invalidate()
+        dict.__delitem__(self, key)
+
+    def clear(self):
+
+        self._invalidate()
+        dict.clear(self)
+
+    def pop(self, *args):
+
+        self._invalidate()
+        return dict.pop(self, *args)
+
+    def popitem(self):
+
+        self._invalidate()
+        return dict.popitem(self)
+
+    def setdefault(self, key, default = None):
+
+        if self._index is not None and not dict.__contains__(self, key):
+            self._invalidate()
+        return dict.setdefault(self, key, default)
+
+    def update(self, *args, **kwds):
+
+        self._invalidate()
+        dict.update(self, *args, **kwds)
+
+    def copy(self):
+
+        return type(self)(self)
+
+    def _build_index(self):
+
+        # A node is a [children, key] pair.
+        root = [{}, None]
+        for key in self.iterkeys():
+            node = root
+            for component in key:
+                children = node[0]
+                child = children.get(component)
+                if child is None:
+                    child = children[component] = [{}, None]
+                node = child
+            node[1] = key
+        self._index = root
+        self._resolved = {}
+        return root
+
+    def _resolve(self, name, scope):
+        """Return the key of 'name' as seen from 'scope', or None.
+        The global scope itself isn't searched."""
+
+        resolved = self._resolved.get(scope)
+        if resolved is None:
+            resolved = self._resolved[scope] = {}
+        elif name in resolved:
+            return resolved[name]
+
+        # Find the nodes of the enclosing scopes, outermost first.
+        nodes = []
+        node = self._index
+        for component in scope:
+            node = node[0].get(component)
+            if node is None: break
+            nodes.append(node)
+        key = None
+        # Look for 'name' in each of them, innermost first.
+        for node in reversed(nodes):
+            for component in name:
+                node = node[0].get(component)
+                if node is None: break
+            else:
+                key = node[1]
+                if key is not None: break
+        resolved[name] = key
+        return key
 
     def lookup(self, name, scopes):
         """locate 'name' in one of the scopes"""
+
+        if self._index is None:
+            self._build_index()
+        if type(name) is list: name = tuple(name)
         for s in scopes:
-            scope = list(s)
-            while len(scope) > 0:
-                if self.has_key(scope + name):
-                    return self[scope + name]
-                else: del scope[-1]
-        if self.has_key(name):
-            return self[name]
-        return None
+            if type(s) is list: s = tuple(s)
+            key = self._resolve(name, s)
+            if key is not None:
+                return dict.__getitem__(self, key)
+        return self.get(name)
 
     def merge(self, dict):
         """merge in a foreign dictionary, overriding already defined types only
@@ -558,10 +717,10 @@ class Visitor(object):
    def visit_forward(self, node): self.visit_declaration(node)
    def visit_group(self, node):
       self.visit_declaration(node)
-      for d in node.declarations: d.accept(self)
+      walk(self, node.declarations)
    def visit_scope(self, node):
       self.visit_declaration(node)
-      for d in node.declarations: d.accept(self)
+      walk(self, node.declarations)
    def visit_module(self, node): self.visit_scope(node)
    def visit_meta_module(self, node): self.visit_module(node)
    def visit_class(self, node): self.visit_scope(node)
@@ -570,21 +729,155 @@ class Visitor(object):
    def visit_enumerator(self, node): self.visit_declaration(node)
    def visit_enum(self, node):
       self.visit_declaration(node)
-      for e in node.enumerators:
-         e.accept(self)
-      if node.eos:
-         node.eos.accept(self)
+      walk(self, _enum_children(node))
    def visit_variable(self, node): self.visit_declaration(node)
    def visit_const(self, node): self.visit_declaration(node)
    def visit_function(self, node):
       self.visit_declaration(node)
-      for parameter in node.parameters: parameter.accept(self)
+      walk(self, node.parameters)
    def visit_function_template(self, node): self.visit_function(node)
    def visit_operation(self, node): self.visit_function(node)
    def visit_operation_template(self, node): self.visit_operation(node)
    def visit_parameter(self, node): pass
    def visit_inheritance(self, node): pass
 
+# What a dispatch table entry does after calling its function, if any.
+_ACCEPT, _LEAF, _DECLARATIONS, _ENUM, _PARAMETERS = range(5)
+
+# The Visitor methods that only call another one.
+_delegates = {'visit_using_directive': 'visit_builtin',
+              'visit_using_declaration': 'visit_builtin',
+              'visit_macro': 'visit_declaration',
+              'visit_forward': 'visit_declaration',
+              'visit_module': 'visit_scope',
+              'visit_meta_module': 'visit_module',
+              'visit_class': 'visit_scope',
+              'visit_class_template': 'visit_class',
+              'visit_typedef': 'visit_declaration',
+              'visit_enumerator': 'visit_declaration',
+              'visit_variable': 'visit_declaration',
+              'visit_const': 'visit_declaration',
+              'visit_function_template': 'visit_function',
+              'visit_operation': 'visit_function',
+              'visit_operation_template': 'visit_operation'}
+
+# The Visitor methods that visit the declaration, then its children.
+_containers = {'visit_group': _DECLARATIONS,
+               'visit_scope': _DECLARATIONS,
+               'visit_enum': _ENUM,
+               'visit_function': _PARAMETERS}
+
+class _Probe(object):
+   """Record the name of the visitor method an 'accept' method calls."""
+
+   def __init__(self): self.name = None
+   def __getattr__(self, name):
+      self.name = name
+      return lambda node: None
+
+_accepted = None
+_tables = {}
+
+def _accepted_method(node_type):
+   """Return (True, name) if the node type's 'accept' method is one of the
+   ASG's, with 'name' the visitor method it calls, if any. Return (False,
+   None) for nodes with other 'accept' methods."""
+
+   global _accepted
+   if _accepted is None:
+      _accepted = {}
+      for c in globals().values():
+         if isinstance(c, type) and 'accept' in c.__dict__:
+            probe = _Probe()
+            try:
+               c.__dict__['accept'](None, probe)
+            except Exception:
+               continue
+            _accepted[c.__dict__['accept']] = probe.name
+   accept = getattr(getattr(node_type, 'accept', None), 'im_func', None)
+   if accept in _accepted:
+      return True, _accepted[accept]
+   return False, None
+
+def _visitor_function(visitor_type, name):
+   """Return the function implementing the named method of the visitor
+   type, or None if it is the one of Visitor."""
+
+   method = getattr(visitor_type, name)
+   function = getattr(method, 'im_func', method)
+   if function is getattr(Visitor, name).im_func:
+      return None
+   return function
+
+def _compile(visitor_type, node_type):
+   """Return the dispatch table entry of the node type for the visitor
+   type, as a (function, kind) pair. Visits through Visitor methods that
+   only delegate are resolved, those that do nothing are dropped."""
+
+   known, name = _accepted_method(node_type)
+   if not known:
+      return None, _ACCEPT
+   while name:
+      if not hasattr(visitor_type, name) or not hasattr(Visitor, name):
+         return None, _ACCEPT
+      function = _visitor_function(visitor_type, name)
+      if function is not None:
+         return function, _LEAF
+      if name in _containers:
+         kind = _containers[name]
+         # Parameters are leaves, so there is no need to walk them if
+         # the visitor ignores them.
+         if (kind is _PARAMETERS and
+             _compile(visitor_type, Parameter) == (None, _LEAF)):
+            kind = _LEAF
+         return _visitor_function(visitor_type, 'visit_declaration'), kind
+      name = _delegates.get(name)
+   return None, _LEAF
+
+def _enum_children(enum):
+
+   for e in enum.enumerators:
+      yield e
+   if enum.eos:
+      yield enum.eos
+
+def walk(visitor, nodes):
+   """Visit the given nodes, with the same effect as calling
+   'node.accept(visitor)' on each. Nodes are dispatched through a table
+   compiled per visitor type, and nested declarations the visitor
+   doesn't handle itself are walked iteratively."""
+
+   visitor_type = visitor.__class__
+   table = _tables.get(visitor_type)
+   if table is None:
+      table = _tables[visitor_type] = {}
+   stack = [iter(nodes)]
+   get = table.get
+   while stack:
+      for node in stack[-1]:
+         entry = get(type(node))
+         if entry is None:
+            entry = table[type(node)] = _compile(visitor_type, type(node))
+         function, kind = entry
+         if function is not None:
+            function(visitor, node)
+         if kind is _LEAF:
+            continue
+         elif kind is _DECLARATIONS:
+            children = node.declarations
+         elif kind is _PARAMETERS:
+            children = node.parameters
+         elif kind is _ENUM:
+            children = _enum_children(node)
+         else:
+            node.accept(visitor)
+            continue
+         if children:
+            stack.append(iter(children))
+            break
+      else:
+         stack.pop()
+
 class ASG(object):
 
     def __init__(self, declarations = None, types = None):
@@ -120,8 +120,7 @@ class ClassTree(ASG.Visitor):
     #
 
     def visit_scope(self, scope):
-        for d in scope.declarations:
-            d.accept(self)
+        ASG.walk(self, scope.declarations)
 
     def visit_class(self, class_):
         """Adds this class and all edges to the lists"""
@@ -135,5 +134,4 @@ class ClassTree(ASG.Visitor):
                 self.add_inheritance(parent.template.name, class_.name)
             elif isinstance(parent, ASG.UnknownTypeId):
                 self.add_inheritance(parent.link, class_.name)
-        for d in class_.declarations:
-            d.accept(self)
+        ASG.walk(self, class_.declarations)
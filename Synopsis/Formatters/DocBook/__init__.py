@@ -11,6 +11,8 @@ from Synopsis.Processor import *
 from Synopsis import ASG, DeclarationSorter
 from Synopsis.Formatters import quote_name
 from Synopsis.Formatters.TOC import TOC
+from Synopsis.Formatters.MarkupCache import MarkupCache
+from Synopsis.Formatters.OutputManifest import OutputManifest
 from Syntax import *
 from Markup.Javadoc import Javadoc
 try:
@@ -94,10 +96,11 @@ class ModuleLister(ASG.Visitor):
 
 class InheritanceFormatter:
 
-    def __init__(self, base_dir, bgcolor):
+    def __init__(self, base_dir, bgcolor, output_files):
 
         self.base_dir = base_dir
         self.bgcolor = bgcolor
+        self.output_files = output_files
 
     def format_class(self, class_, format):
 
@@ -108,10 +111,11 @@ class InheritanceFormatter:
         filename = os.path.join(self.base_dir, escape(str(class_.name)) + '.%s'%format)
         dot = Dot.Formatter(bgcolor=self.bgcolor)
         try:
-            dot.process(IR.IR(asg = ASG.ASG(declarations = [class_])),
-                        output=filename,
-                        format=format,
-                        type='single')
+            text = dot.generate(IR.IR(asg = ASG.ASG(declarations = [class_])),
+                                format=format,
+                                type='single')
+            Dot.render(text, [(format, filename)],
+                       output_files=self.output_files)
             return filename
         except InvalidCommand, e:
             print 'Warning : %s'%str(e)
@@ -399,7 +403,8 @@ class DetailFormatter(FormatterBase, ASG.Visitor):
         
         if self.inheritance_graphs:
             formatter = InheritanceFormatter(os.path.join(self.base_dir, 'images'),
-                                             self.graph_color)
+                                             self.graph_color,
+                                             self.processor.output_files)
             png = formatter.format_class(class_, 'png')
             svg = formatter.format_class(class_, 'svg')
             if png or svg:
@@ -505,7 +510,7 @@ class DetailFormatter(FormatterBase, ASG.Visitor):
 class DocCache:
     """"""
 
-    def __init__(self, processor, markup_formatters):
+    def __init__(self, processor, markup_formatters, markup_cache = None):
 
         self._processor = processor
         self._markup_formatters = markup_formatters
@@ -515,6 +520,7 @@ class DocCache:
         for f in self._markup_formatters.values():
             f.init(self._processor)
         self._doc_cache = {}
+        self.markup_cache = markup_cache
 
 
     def _process(self, decl):
@@ -526,7 +532,10 @@ class DocCache:
             if doc:
                 formatter = self._markup_formatters.get(doc.markup,
                                                         self._markup_formatters[''])
-                doc = formatter.format(decl)
+                if self.markup_cache:
+                    doc = self.markup_cache.format(formatter, decl)
+                else:
+                    doc = formatter.format(decl)
             else:
                 doc = Markup.Struct()
             self._doc_cache[key] = doc
@@ -565,6 +574,7 @@ class Formatter(Processor):
     secondary_index_terms = Parameter(True, 'add fully-qualified names to index')
     with_inheritance_graphs = Parameter(True, 'whether inheritance graphs should be generated')
     graph_color = Parameter('#ffcc99', 'base color for inheritance graphs')
+    markup_cache = Parameter('', 'file in which to cache formatted documentation across runs')
    
     def process(self, ir, **kwds):
 
@@ -572,12 +582,17 @@ class Formatter(Processor):
         if not self.output: raise MissingArgument('output')
         self.ir = self.merge_input(ir)
 
-        self.documentation = DocCache(self, self.markup_formatters)
+        markup_cache = self.markup_cache and MarkupCache(self.markup_cache) or None
+        self.documentation = DocCache(self, self.markup_formatters, markup_cache)
         self.toc = TOC(Linker())
         for d in self.ir.asg.declarations:
             d.accept(self.toc)
 
-        output = open(self.output, 'w')
+        # Only write the output if it changed since the last run.
+        output_files = OutputManifest(self.output + '.digests',
+                                      os.path.dirname(self.output))
+        self.output_files = output_files
+        output = output_files.open(os.path.basename(self.output))
         output.write('<section>\n')
         if self.title:
             output.write('<title>%s</title>\n'%self.title)
@@ -610,5 +625,13 @@ class Formatter(Processor):
             
         output.write('</section>\n')
         output.close()
+        output_files.finish()
+        if self.verbose or self.profile:
+            print 'Output: %s'%output_files.report()
+        if markup_cache:
+            markup_cache.save()
+            if self.verbose or self.profile:
+                print 'Markup cache: %d hits, %d misses'%(markup_cache.hits,
+                                                          markup_cache.misses)
       
         return self.ir
@@ -14,8 +14,16 @@ from Synopsis.Processor import *
 from Synopsis.QualifiedName import *
 from Synopsis import ASG
 from Synopsis.Formatters import TOC
-from Synopsis.Formatters import quote_name, open_file
-import sys, os
+from Synopsis.Formatters import open_file, make_dirs
+from cStringIO import StringIO
+import sys, os, shutil, filecmp, subprocess, tempfile
+try:
+   import hashlib
+   md5 = hashlib.md5
+except ImportError:
+   # 2.4 compatibility
+   import md5
+   md5 = md5.new
 
 verbose = False
 debug = False
@@ -405,39 +413,156 @@ def _convert_map(input, output, base_url):
          output.write(str(x1) + ", " + str(y1) + ", " + str(x2) + ", " + str(y2) + '" />\n')
       line = input.readline()
 
-def _format(input, output, format):
+_extensions = {'imap' : 'map'}
 
-   command = 'dot -T%s -o "%s" "%s"'%(format, output, input)
-   if verbose: print "Dot Formatter: running command '" + command + "'"
+def _run(text, outputs):
+   """Run 'dot' once on the given 'text', generating all 'outputs', a
+   list of (format, filename) pairs."""
+
+   command = ['dot']
+   for format, output in outputs:
+      command.extend(['-T%s'%format, '-o', output])
+   if verbose: print "Dot Formatter: running command '%s'"%' '.join(command)
    try:
-      system(command)
-   except SystemError, e:
+      dot = subprocess.Popen(command, stdin=subprocess.PIPE)
+      dot.communicate(text)
+      status = dot.returncode
+   except OSError:
+      status = -1
+   if status != 0:
       if debug:
-         print 'failed to execute "%s"'%command
+         print 'failed to execute "%s"'%' '.join(command)
       raise InvalidCommand, "could not execute 'dot'"
 
-def _format_png(input, output): _format(input, output, "png")
+def cached(text, formats, cache):
+   """Return the files in the 'cache' directory holding the given 'text'
+   rendered into each of 'formats', keyed by a digest of the text."""
+
+   key = md5(text).hexdigest()
+   return [os.path.join(cache, key[:2], '%s.%s'%(key, _extensions.get(f, f)))
+           for f in formats]
+
+def _render_cached(args):
+   """Render 'text' into the cache, unless it is already there.
+   This runs inside a worker process of 'prerender'."""
 
-def _format_html(input, output, base_url):
+   text, formats, cache = args
+   files = cached(text, formats, cache)
+   if [f for f in files if not os.path.exists(f)]:
+      directory = os.path.dirname(files[0])
+      if not os.path.isdir(directory):
+         try:
+            os.makedirs(directory)
+         except OSError:
+            # Another worker may have created it meanwhile.
+            if not os.path.isdir(directory): raise
+      # Render under temporary names, so concurrent runs never see
+      # partial results.
+      tmp = ['%s.%d'%(f, os.getpid()) for f in files]
+      _run(text, zip(formats, tmp))
+      for t, f in zip(tmp, files): os.rename(t, f)
+   return files
+
+def _write(source, output, output_files):
+   """Copy the rendered file 'source' to 'output', through 'output_files'
+   (an `OutputManifest`) if given, and otherwise only if it changed."""
+
+   if output_files:
+      file = open(source, 'rb')
+      try:
+         output_files.write(os.path.abspath(output), file.read())
+      finally:
+         file.close()
+   elif not os.path.exists(output) or not filecmp.cmp(source, output, False):
+      make_dirs(os.path.dirname(output))
+      shutil.copyfile(source, output)
+
+def render(text, outputs, cache = '', output_files = None):
+   """Render 'text' into all 'outputs', a list of (format, filename)
+   pairs, using a single 'dot' run. If a 'cache' directory is given,
+   graphs are only rendered if they aren't in the cache already.
+   If 'output_files' (an `OutputManifest`) is given, the outputs are
+   written through it, so it can skip unchanged files and remove files
+   no longer generated."""
+
+   if output_files:
+      directory = tempfile.mkdtemp()
+      try:
+         rendered = [(f, os.path.join(directory, '%d.%s'%(i, f)))
+                     for i, (f, o) in enumerate(outputs)]
+         render(text, rendered, cache)
+         for (f, r), (f, o) in zip(rendered, outputs):
+            _write(r, o, output_files)
+      finally:
+         shutil.rmtree(directory, True)
+      return
+   for f, o in outputs: make_dirs(os.path.dirname(o))
+   if not cache:
+      _run(text, outputs)
+      return
+   formats = [f for f, o in outputs]
+   for c, (f, o) in zip(_render_cached((text, formats, cache)), outputs):
+      # Leave outputs that are up to date alone.
+      _write(c, o, None)
+
+def prerender(texts, formats, cache, jobs = 1):
+   """Fill the 'cache' directory with the given graphs, rendering those
+   not yet in the cache with a pool of 'jobs' worker processes."""
+
+   texts = [t for t in texts
+            if [f for f in cached(t, formats, cache) if not os.path.exists(f)]]
+   if not texts: return
+   if jobs > 1 and len(texts) > 1:
+      import multiprocessing
+      pool = multiprocessing.Pool(jobs)
+      try:
+         pool.map(_render_cached, [(t, formats, cache) for t in texts])
+      finally:
+         pool.close()
+         pool.join()
+   else:
+      for t in texts: _render_cached((t, formats, cache))
+
+def _format(text, output, format, cache = ''): render(text, [(format, output)], cache)
+
+def _format_png(text, output, cache = ''): _format(text, output, "png", cache)
+
+def html_graph(text, output, base_url, cache = '', output_files = None):
+   """Render 'text' into the image 'output'.png, and return the html
+   showing it, with an image map linking to urls relative to 'base_url'.
+   If 'output_files' (an `OutputManifest`) is given, the image is
+   written through it."""
+
+   prefix, name = os.path.split(output)
+   directory = tempfile.mkdtemp()
+   try:
+      image = os.path.join(directory, name + ".png")
+      map = os.path.join(directory, name + ".map")
+      render(text, [('png', image), ('imap', map)], cache)
+      _write(image, output + ".png", output_files)
+      reference = name + ".png"
+      html = StringIO()
+      html.write('<img alt="'+name+'" src="' + reference + '" hspace="8" vspace="8" border="0" usemap="#')
+      html.write(name + "_map\" />\n")
+      html.write("<map name=\"" + name + "_map\">")
+      dotmap = open(map, "r+")
+      _convert_map(dotmap, html, base_url)
+      dotmap.close()
+      html.write("</map>\n")
+      return html.getvalue()
+   finally:
+      shutil.rmtree(directory, True)
+
+def _format_html(text, output, base_url, cache = ''):
    """generate (active) image for html.
-   input and output are file names. If output ends
+   output is a file name. If output ends
    in '.html', its stem is used with an '.png' suffix for the
    actual image."""
 
    if output[-5:] == ".html": output = output[:-5]
-   _format_png(input, output + ".png")
-   _format(input, output + ".map", "imap")
-   prefix, name = os.path.split(output)
-   reference = name + ".png"
    html = open_file(output + ".html")
-   html.write('<img alt="'+name+'" src="' + reference + '" hspace="8" vspace="8" border="0" usemap="#')
-   html.write(name + "_map\" />\n")
-   html.write("<map name=\"" + name + "_map\">")
-   dotmap = open(output + ".map", "r+")
-   _convert_map(dotmap, html, base_url)
-   dotmap.close()
-   os.remove(output + ".map")
-   html.write("</map>\n")
+   html.write(html_graph(text, output, base_url, cache))
+   html.close()
 
 class Formatter(Processor):
    """The Formatter class acts merely as a frontend to
@@ -454,48 +579,33 @@ class Formatter(Processor):
    prefix = Parameter(None, 'Prefix to strip from all class names')
    toc_in = Parameter([], 'list of table of content files to use for symbol lookup')
    base_url = Parameter(None, 'base url to use for generated links')
+   cache = Parameter('', 'directory in which to cache rendered graphs across runs')
 
-   def process(self, ir, **kwds):
+   def generate(self, ir, **kwds):
+      """Return the dot input for the graph of the given IR."""
       global verbose, debug
       
       self.set_parameters(kwds)
+      bgcolor = None
       if self.bgcolor:
          bgcolor = normalize(self.bgcolor)
          if not bgcolor:
             raise InvalidArgument('bgcolor=%s'%repr(self.bgcolor))
-         else:
-            self.bgcolor = bgcolor
 
       self.ir = self.merge_input(ir)
       verbose = self.verbose
       debug = self.debug
 
-      formats = {'dot' : 'dot',
-                 'ps' : 'ps',
-                 'png' : 'png',
-                 'gif' : 'gif',
-                 'svg' : 'svg',
-                 'map' : 'imap',
-                 'html' : 'html'}
-
-      if formats.has_key(self.format): format = formats[self.format]
-      else:
-         print "Error: Unknown format. Available formats are:",
-         print ', '.join(formats.keys())
-         return self.ir
-
       # we only need the toc if format=='html'
-      if format == 'html':
+      if self.format == 'html':
          # beware: HTML.Fragments.ClassHierarchyGraph sets self.toc !!
          toc = getattr(self, 'toc', TOC.TOC(TOC.Linker()))
          for t in self.toc_in: toc.load(t)
       else:
          toc = None
 
-      head, tail = os.path.split(self.output)
-      tmpfile = os.path.join(head, quote_name(tail)) + ".dot"
-      if self.verbose: print "Dot Formatter: Writing dot file..."
-      dotfile = open_file(tmpfile)
+      if self.verbose: print "Dot Formatter: Generating dot input..."
+      dotfile = StringIO()
       dotfile.write("digraph \"%s\" {\n"%(self.title))
       if self.layout == 'horizontal':
          dotfile.write('rankdir="LR";\n')
@@ -507,16 +617,16 @@ class Formatter(Processor):
                                                 not self.hide_attributes,
                                                 -1, self.ir.asg.types,
                                                 toc, self.prefix, False,
-                                                self.bgcolor)
+                                                bgcolor)
       elif self.type == 'class':
          generator = InheritanceGenerator(dotfile, self.layout,
                                           not self.hide_operations,
                                           not self.hide_attributes,
                                           self.show_aggregation,
                                           toc, self.prefix, False,
-                                          self.bgcolor)
+                                          bgcolor)
       elif self.type == 'file':
-         generator = FileDependencyGenerator(dotfile, self.layout, self.bgcolor)
+         generator = FileDependencyGenerator(dotfile, self.layout, bgcolor)
       else:
          sys.stderr.write("Dot: unknown type\n");
          
@@ -528,18 +638,35 @@ class Formatter(Processor):
          for d in self.ir.asg.declarations:
             d.accept(generator)
       dotfile.write("}\n")
-      dotfile.close()
+      return dotfile.getvalue()
+
+   def process(self, ir, **kwds):
+
+      self.set_parameters(kwds)
+      formats = {'dot' : 'dot',
+                 'ps' : 'ps',
+                 'png' : 'png',
+                 'gif' : 'gif',
+                 'svg' : 'svg',
+                 'map' : 'imap',
+                 'html' : 'html'}
+
+      if formats.has_key(self.format): format = formats[self.format]
+      else:
+         print "Error: Unknown format. Available formats are:",
+         print ', '.join(formats.keys())
+         return self.merge_input(ir)
+
+      text = self.generate(ir)
       if format == "dot":
-         os.rename(tmpfile, self.output)
+         dotfile = open_file(self.output)
+         dotfile.write(text)
+         dotfile.close()
       elif format == "png":
-         _format_png(tmpfile, self.output)
-         os.remove(tmpfile)
+         _format_png(text, self.output, self.cache)
       elif format == "html":
-         _format_html(tmpfile, self.output, self.base_url)
-         os.remove(tmpfile)
+         _format_html(text, self.output, self.base_url, self.cache)
       else:
-         _format(tmpfile, self.output, format)
-         os.remove(tmpfile)
+         _format(text, self.output, format, self.cache)
 
       return self.ir
-
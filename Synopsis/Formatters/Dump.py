@@ -72,6 +72,7 @@ class Formatter(Processor):
             self.write_files(self.ir.files)
 
         self.os.write("</ir>\n")
+        self.os.close()
 
         return self.ir
 
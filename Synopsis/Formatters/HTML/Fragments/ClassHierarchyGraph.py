@@ -14,39 +14,73 @@ import os
 
 class ClassHierarchyGraph(ClassHierarchySimple):
     """Prints a graphical hierarchy for classes, using the Dot formatter.
+
+    Graphs are rendered through the processor's graph cache. If more than
+    one job is requested, the graphs of all classes that get a page in a
+    Scope view are rendered up-front by a pool of worker processes, so
+    individual classes are then served from the cache.
    
     @see Formatters.Dot
     """
-    def format_class(self, class_):
+
+    prerendered = False
+
+    def register(self, part):
+
+        super(ClassHierarchyGraph, self).register(part)
+        self.texts = {}
+
+    def graph_label(self, filename):
+
+        return filename[:-5] + '-inheritance.html'
+
+    def generate(self, class_, label):
+        """Return the dot input for the graph of the given class, or ''
+        if it has neither base nor derived classes."""
 
         from Synopsis.Formatters import Dot
-        super = self.processor.class_tree.superclasses(class_.name)
-        sub = self.processor.class_tree.subclasses(class_.name)
-        if len(super) == 0 and len(sub) == 0:
-            # Skip classes with a boring graph
+        class_tree = self.processor.class_tree
+        if (not class_tree.superclasses(class_.name) and
+            not class_tree.subclasses(class_.name)):
             return ''
-        #label = self.processor.files.scoped_special('inheritance', clas.name)
-        label = self.part.filename()[:-5] + '-inheritance.html'
-        tmp = os.path.join(self.processor.output, label)
         ir = IR.IR(files={}, asg=ASG.ASG([class_], self.processor.ir.asg.types))
         dot = Dot.Formatter(bgcolor=self.processor.graph_color)
         dot.toc = self.processor.toc
+        return dot.generate(ir, format='html', type='single', title=label)
+
+    def prerender(self):
+        """Render the graphs of all classes with a page in the view into
+        the graph cache, and keep their dot input for format_class."""
+
+        from Synopsis.Formatters import Dot
+        from Synopsis.Formatters.HTML.Views.Scope import Scope
+        if not isinstance(self.view, Scope): return
+        for scope, is_root in self.view.pages():
+            if not isinstance(scope, (ASG.Class, ASG.ClassTemplate)): continue
+            label = self.graph_label(self.view.scope_filename(scope, is_root))
+            self.texts[label] = self.generate(scope, label)
+        Dot.prerender([t for t in self.texts.values() if t], ['png', 'imap'],
+                      self.processor.graphs, self.processor.jobs)
+
+    def format_class(self, class_):
+
+        from Synopsis.Formatters import Dot
+        if self.processor.jobs > 1 and not self.prerendered:
+            self.prerendered = True
+            self.prerender()
+        #label = self.processor.files.scoped_special('inheritance', clas.name)
+        label = self.graph_label(self.part.filename())
+        text = self.texts.pop(label, None)
+        if text is None:
+            text = self.generate(class_, label)
+        if not text:
+            # Skip classes with a boring graph
+            return ''
+        output = os.path.join(self.processor.output, label[:-5])
         try:
-            dot.process(ir,
-                        output=tmp,
-                        format='html',
-                        base_url=self.part.filename(),
-                        type='single',
-                        title=label)
-            text = ''
-            input = open(tmp, "r+")
-            line = input.readline()
-            while line:
-                text = text + line
-                line = input.readline()
-            input.close()
-            os.unlink(tmp)
-            return text
+            return Dot.html_graph(text, output, self.part.filename(),
+                                  self.processor.graphs,
+                                  self.processor.output_files)
         except InvalidCommand, e:
             print 'Warning : %s'%str(e)
             return ''
@@ -5,8 +5,27 @@
 # see the file COPYING for details.
 #
 
+from Synopsis import Profiler
 from Synopsis.Formatters.HTML.Tags import *
-import sys, time
+import os
+
+_view = None
+_pages = None
+
+def _process_pages(indices):
+    """Generate the given pages of '_view'. This runs inside a worker
+    process forked by 'Frame.process_parallel', which inherits the view
+    and all the data it shares with other views."""
+
+    # Don't let workers start pools of their own.
+    _view.processor.jobs = 1
+    for i in indices:
+        _view.process_page(_pages[i])
+    # Pass the files written and newly formatted documentation
+    # back to the main process.
+    markup_cache = _view.processor.documentation.markup_cache
+    return (_view.processor.output_files.updates(),
+            markup_cache and markup_cache.updates() or {})
 
 class Frame:
     """A Frame is a mediator for views that get displayed in it (as well
@@ -28,13 +47,49 @@ class Frame:
             v.register_filenames()
 
         for v in self.views:
-            if self.processor.profile:
-                print 'Time for %s:'%v.__class__.__name__,
-                sys.stdout.flush()
-                start_time = time.time()
-            v.process()
-            if self.processor.profile:
-                print '%f seconds'%(time.time() - start_time)
+            zone = Profiler.zone('%s.%s'%(v.__class__.__module__,
+                                          v.__class__.__name__))
+            try:
+                # Workers find the view through module globals, which
+                # only forked processes inherit.
+                pages = self.processor.jobs > 1 and hasattr(os, 'fork') and v.pages()
+                if pages:
+                    self.process_parallel(v, pages)
+                else:
+                    v.process()
+            finally:
+                zone.end()
+
+
+    def process_parallel(self, view, pages):
+        """Generate the pages of the given view in a pool of worker
+        processes. Since pages are independent of each other, the output
+        is the same as if they were generated in order by a single process."""
+
+        global _view, _pages
+        import multiprocessing
+        jobs = min(self.processor.jobs, len(pages))
+        # Hand out pages in small batches, as their cost varies a lot.
+        size = max(1, len(pages) / (jobs * 4))
+        batches = [range(i, min(i + size, len(pages)))
+                   for i in range(0, len(pages), size)]
+        _view, _pages = view, pages
+        # Workers report the files they write, so they need to start
+        # without any files recorded by this process.
+        output_files = self.processor.output_files
+        written = output_files.updates()
+        pool = multiprocessing.Pool(jobs)
+        try:
+            updates = pool.map(_process_pages, batches, 1)
+        finally:
+            pool.close()
+            pool.join()
+            _view, _pages = None, None
+        output_files.merge(written)
+        markup_cache = self.processor.documentation.markup_cache
+        for files, markup in updates:
+            output_files.merge(files)
+            if markup_cache: markup_cache.merge(markup)
 
 
     def navigation_bar(self, view):
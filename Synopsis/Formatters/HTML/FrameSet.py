@@ -5,17 +5,17 @@
 # see the file COPYING for details.
 #
 
-from Synopsis.Formatters import open_file
 from Synopsis.Formatters.HTML.Tags import *
 import os
 
 class FrameSet:
     """A class that creates an index with frames"""
 
-    def process(self, output, filename, title, index, detail, content):
-        """Creates a frames index file."""
+    def process(self, output_files, filename, title, index, detail, content):
+        """Creates a frames index file, written through the 'output_files'
+        manifest."""
 
-        out = open_file(os.path.join(output, filename))
+        out = output_files.open(filename)
         out.write('<?xml version="1.0"?>\n')
         out.write('<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Frameset//EN"\n')
         out.write('    "http://www.w3.org/TR/xhtml1/DTD/xhtml1-frameset.dtd">\n')
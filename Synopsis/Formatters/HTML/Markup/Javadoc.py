@@ -208,7 +208,7 @@ class Javadoc(Formatter):
                     name = name.replace('#', '.')
             target = self.lookup_symbol(name, decl.name[:-1])
             if target:
-                url = rel(view.filename(), target)
+                url = self.link(view, target)
                 text += href(url, label)
             else:
                 text += label
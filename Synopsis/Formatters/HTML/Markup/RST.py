@@ -82,7 +82,7 @@ class RST(Formatter):
             name = utils.unescape(text)
             uri = formatter.lookup_symbol(name, decl.name[:-1])
             if uri:
-                ref = rel(view.filename(), uri)
+                ref = formatter.link(view, uri)
                 node = reference(rawtext, name, refuri=ref, **options)
             else:
                 node = emphasis(rawtext, name)
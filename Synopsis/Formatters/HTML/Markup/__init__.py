@@ -9,9 +9,17 @@
 from Synopsis.Processor import Parametrized, Parameter
 from Synopsis import ASG
 from Synopsis.QualifiedName import *
-from Synopsis.Formatters.HTML.Tags import escape
+from Synopsis.Formatters.HTML.Tags import escape, rel
 import re
 
+_link = re.compile(r'@@synopsis-link:([^@]*)@@')
+
+def resolve_links(text, filename):
+    """Replace the symbolic links in 'text' by URLs relative to 'filename'."""
+
+    if '@@synopsis-link:' not in text: return text
+    return _link.sub(lambda m: rel(filename, m.group(1)), text)
+
 class Struct:
 
     def __init__(self, summary = '', details = ''):
@@ -33,7 +41,8 @@ class Formatter(Parametrized):
     def format(self, decl, view):
         """Format the declaration's documentation.
         @param view the View to use for references and determining the correct
-        relative filename.
+        relative filename. If None, links are generated in symbolic form
+        (see link()).
         @param decl the declaration
         @returns Struct containing summary / details pair.
         """
@@ -44,6 +53,15 @@ class Formatter(Parametrized):
         summary = m and m.group(1) or ''
         return Struct(summary, text)
 
+    def link(self, view, target):
+        """Return the URL to use in 'view' to refer to 'target'. Without a
+        view, return a symbolic link, to be resolved by resolve_links() once
+        the view is known. This allows formatted documentation to be shared
+        across views."""
+
+        if view is None: return '@@synopsis-link:%s@@'%target
+        return rel(view.filename(), target)
+
     def lookup_symbol(self, symbol, scope):
         """Given a symbol and a scope, returns an URL.
         Various methods are tried to resolve the symbol. First the
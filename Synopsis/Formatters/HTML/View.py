@@ -11,7 +11,6 @@ View base class, contains base functionality and common interface for all Views.
 """
 
 from Synopsis.Processor import Parametrized, Parameter
-from Synopsis.Formatters import open_file_with_encoding
 from Tags import *
 
 import re, os
@@ -177,8 +176,9 @@ class View(Parametrized):
 
 
     def generate_id(self):
-        """Generate an id that is (at least) unique on a particular view,
-        and thus, html document."""
+        """Generate an id that is unique within the current html document.
+        Ids restart with each document, so a document's content doesn't
+        depend on the documents generated before it."""
 
         c = self._id_counter
         self._id_counter += 1
@@ -240,13 +240,26 @@ class View(Parametrized):
 
         pass
 
+    def pages(self):
+        """Return the list of independent pages this view generates, if it
+        can generate them in any order (and in parallel), by passing each
+        to process_page(). The default implementation returns None, in
+        which case the view is generated by process()."""
+
+        return None
+
+    def process_page(self, page):
+        """Generate a single page, as returned by pages()."""
+
+        pass
+
     def open_file(self):
         """Returns a new output stream. This template method is for internal
         use only, but may be overriden in derived classes.
-        The default joins output dir and self.filename()"""
+        The default returns an in-memory stream for self.filename(), which
+        is only written to the output directory if its content changed."""
 
-        path = os.path.join(self.processor.output, self.filename())
-        return open_file_with_encoding(path, 'utf-8')
+        return self.processor.output_files.open(self.filename(), 'utf-8')
 
     def close_file(self):
         """Closes the internal output stream. This template method is for
@@ -265,6 +278,7 @@ class View(Parametrized):
         stored and can be accessed using the os() method."""
 
         self.__os = self.open_file()
+        self._id_counter = 0
         prefix = rel(self.filename(), '')
         self.template.init(self.processor, prefix)
         if not body:
@@ -172,7 +172,7 @@ class Directory(View):
         """Overrides end_file to provide synopsis logo"""
 
         self.write('\n')
-        now = time.strftime(r'%c', time.localtime(time.time()))
+        now = time.strftime(r'%c', time.localtime(self.processor.start_time))
         logo = img(src=rel(self.filename(), 'synopsis.png'), alt='logo')
         logo = href('http://synopsis.fresco.org', logo + ' synopsis', target='_blank')
         logo += ' (version %s)'%config.version
@@ -155,17 +155,14 @@ class InheritanceGraph(View):
             dot = Dot.Formatter(bgcolor=self.processor.graph_color)
             ir = IR.IR(files={}, asg=ASG.ASG(declarations, self.processor.ir.asg.types))
             try:
-               dot.process(ir,
-                           output=output,
-                           format='html',
-                           toc_in=[toc_file],
-                           base_url=self.filename(),
-                           title='Synopsis %s'%count,
-                           layout=self.direction)
-               dot_file = open(output + '.html', 'r')
-               self.write(dot_file.read())
-               dot_file.close()
-               os.remove(output + ".html")
+               text = dot.generate(ir,
+                                   format='html',
+                                   toc_in=[toc_file],
+                                   title='Synopsis %s'%count,
+                                   layout=self.direction)
+               self.write(Dot.html_graph(text, output, self.filename(),
+                                         self.processor.graphs,
+                                         self.processor.output_files))
             except InvalidCommand, e:
                print 'Warning : %s'%str(e)
             count = count + 1
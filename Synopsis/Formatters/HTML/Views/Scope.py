@@ -69,11 +69,18 @@ class Scope(View):
     def process(self):
         """Creates a view for every Scope."""
 
+        for page in self.pages():
+            self.process_page(page)
+
+    def pages(self):
+        """Return a (scope, is_root) pair for every Scope view."""
+
         module = self.processor.root
+        pages = []
         self.scopes_queue = [module]
         while self.scopes_queue:
             scope = self.scopes_queue.pop(0)
-            self.process_scope(scope, scope == module)
+            pages.append((scope, scope == module))
             scopes = [c for c in scope.declarations if isinstance(c, (ASG.Scope, ASG.Group))]
             self.scopes_queue.extend(scopes)
             forwards = [c for c in scope.declarations
@@ -81,8 +88,19 @@ class Scope(View):
             # Treat forward-declared class template like a scope if it has
             # specializations, since these are only listed in a Scope view.
             # Process them directly as they don't have child declarations.
-            for f in forwards:
-                self.process_scope(f)
+            pages.extend([(f, False) for f in forwards])
+        # Scopes may occur more than once (such as a Python package, for
+        # each of its modules). Only the last one generates the page, as
+        # it would overwrite the others anyway.
+        last = {}
+        for i, (scope, is_root) in enumerate(pages):
+            last[self.scope_filename(scope, is_root)] = i
+        return [p for i, p in enumerate(pages)
+                if last[self.scope_filename(*p)] == i]
+
+    def process_page(self, page):
+
+        self.process_scope(*page)
 
     def register_filenames(self):
         """Registers a view for every Scope."""
@@ -99,23 +117,31 @@ class Scope(View):
             scopes = [c for c in scope.declarations if isinstance(c, ASG.Module)]
             self.scopes_queue.extend(scopes)
      
-    def process_scope(self, scope, is_root = False):
-        """Creates a view for the given scope"""
+    def scope_filename(self, scope, is_root = False):
+        """Return the filename of the view for the given scope."""
 
-        # Open file and setup scopes
-        self.__scope = scope.name
-        if self.__scope:
+        if scope.name:
             # Hack: if this is the toplevel scope in a no-frames context,
             #       generate the index page. This of course is based on a number
             #       of assumptions that may not be valid (such as this module producing
             #       the 'main' view.
             if is_root and not Tags.using_frames:
-                self.__filename, xxx = self.root()
+                return self.root()[0]
             else:
-                self.__filename = self.directory_layout.scope(self.__scope)
+                return self.directory_layout.scope(scope.name)
+        else:
+            return self.root()[0]
+
+    def process_scope(self, scope, is_root = False):
+        """Creates a view for the given scope"""
+
+        # Open file and setup scopes
+        self.__scope = scope.name
+        self.__filename = self.scope_filename(scope, is_root)
+        if self.__scope:
             self.__title = escape(str(self.__scope))
         else:
-            self.__filename, self.__title = self.root()
+            self.__title = self.root()[1]
         self.start_file()
         self.write_navigation_bar()
         # Loop throught all the view Parts
@@ -127,7 +153,7 @@ class Scope(View):
         """Overrides end_file to provide synopsis logo"""
 
         self.write('\n')
-        now = time.strftime(r'%c', time.localtime(time.time()))
+        now = time.strftime(r'%c', time.localtime(self.processor.start_time))
         logo = img(src=rel(self.filename(), 'synopsis.png'), alt='logo')
         logo = href('http://synopsis.fresco.org', logo + ' synopsis', target='_blank')
         logo += ' (version %s)'%config.version
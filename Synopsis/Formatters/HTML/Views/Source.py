@@ -8,6 +8,7 @@
 
 from Synopsis import config
 from Synopsis.Processor import *
+from Synopsis import SXRFormat
 from Synopsis.QualifiedName import *
 from Synopsis.Formatters import join_paths
 from Synopsis.Formatters.HTML.View import View
@@ -64,6 +65,65 @@ class SXRTranslator:
         writer.write('</pre>')
 
 
+class BinarySXRTranslator:
+    """Read in an sxr file in the binary format, resolve references,
+    and write it out as part of a Source view."""
+
+    def __init__(self, filename, language, debug):
+
+        try:
+            self.sxr = SXRFormat.Reader(filename)
+        except:
+            if debug:
+                print 'Error parsing', filename
+                raise
+            else:
+                raise InternalError('parsing %s'%filename)
+        if language == 'Python':
+            self.qname = lambda name: QualifiedPythonName(str(name).split('.'))
+        else:
+            self.qname = lambda name: QualifiedCxxName(str(name).split('::'))
+        self.linker = None
+
+    def link(self, linker):
+
+        # Links are resolved as lines are written out.
+        self.linker = linker
+
+    def translate(self, writer):
+
+        escape = SXRFormat.escape
+        writer.write('<pre class="sxr">')
+        lines = self.sxr.lines()
+        lineno_template = '%%%ds' % len(`lines`)
+        for lineno in xrange(lines):
+            writer.write('<a id="line%d"></a>'%(lineno + 1))
+            text = lineno_template % (lineno + 1)
+            writer.write('<span class="lineno">%s</span>'%text)
+            line, spans = self.sxr.line(lineno)
+            chunks = []
+            column = 0
+            for c, l, flags, a, b, c_ in spans:
+                chunks.append(escape(line[column:c]))
+                content = escape(line[c:c + l])
+                if flags & SXRFormat.ANCHOR:
+                    target = self.linker and self.linker(self.qname(a)) or a
+                    chunks.append('<a href="%s">%s</a>'%(escape(target), content))
+                elif flags & SXRFormat.CONTINUATION:
+                    chunks.append('<span class="%s" continuation="true">%s</span>'
+                                  %(a, content))
+                else:
+                    chunks.append('<span class="%s">%s</span>'%(a, content))
+                column = c + l
+            chunks.append(escape(line[column:]))
+            text = ''.join(chunks)
+            if text:
+                writer.write('<span class="line">%s</span>\n'%text)
+            else:
+                writer.write('\n')
+        writer.write('</pre>')
+
+
 class Source(View):
     """A module for creating a view for each file with hyperlinked source"""
 
@@ -96,15 +156,25 @@ class Source(View):
     def process(self):
         """Creates a view for every file"""
 
+        for file in self.pages():
+            self.process_node(file)
+
+
+    def pages(self):
+        """Return the primary files, each of which gets a view."""
+
         self.prefix = self.processor.sxr_prefix
-        if self.prefix is None: return
+        if self.prefix is None: return []
         
         # Get the TOC
         self.__toc = self.processor.toc
-        # create a view for each primary file
-        for file in self.processor.ir.files.values():
-            if file.annotations['primary']:
-                self.process_node(file)
+        return [f for f in self.processor.ir.files.values()
+                if f.annotations['primary']]
+
+
+    def process_page(self, file):
+
+        self.process_node(file)
 
 
     def register_filenames(self):
@@ -136,7 +206,9 @@ class Source(View):
 
         sxr = join_paths(self.prefix, source + '.sxr')
         if os.path.exists(sxr):
-            translator = SXRTranslator(sxr, file.annotations['language'], self.processor.debug)
+            if SXRFormat.is_binary(sxr): translator = BinarySXRTranslator
+            else: translator = SXRTranslator
+            translator = translator(sxr, file.annotations['language'], self.processor.debug)
             linker = self.external_url and self.external_ref or self.lookup_symbol
             translator.link(linker)
             translator.translate(self)
@@ -157,7 +229,7 @@ class Source(View):
         """Overrides end_file to provide synopsis logo"""
 
         self.write('\n')
-        now = time.strftime(r'%c', time.localtime(time.time()))
+        now = time.strftime(r'%c', time.localtime(self.processor.start_time))
         logo = img(src=rel(self.filename(), 'synopsis.png'), alt='logo')
         logo = href('http://synopsis.fresco.org', logo + ' synopsis', target='_blank')
         logo += ' (version %s)'%config.version
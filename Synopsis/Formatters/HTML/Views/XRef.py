@@ -54,24 +54,31 @@ class XRef(View):
 
     def process(self):
 
-        if self.processor.sxr_prefix is None: return
+        for p in self.pages():
+            self.process_page(p)
+
+    def pages(self):
+        """Return the indices of all xref pages."""
+
+        if self.processor.sxr_prefix is None: return []
+        return range(len(self.processor.xref.pages()))
+
+    def process_page(self, p):
 
         pages = self.processor.xref.pages()
-        if not pages: return
-        for p in range(len(pages)):
-            self.__filename = self.directory_layout.xref(p)
+        self.__filename = self.directory_layout.xref(p)
 
-            first, last = pages[p][0], pages[p][-1]
-            self.__title = 'Cross Reference : %s - %s'%(escape(str(first)), escape(str(last)))
+        first, last = pages[p][0], pages[p][-1]
+        self.__title = 'Cross Reference : %s - %s'%(escape(str(first)), escape(str(last)))
 
-            self.start_file()
-            self.write_navigation_bar()
-            self.write(element('h1', self.title()))
-            for name in pages[p]:
-                self.write('<div class="xref-name">')
-                self.process_name(name)
-                self.write('</div>')
-            self.end_file()
+        self.start_file()
+        self.write_navigation_bar()
+        self.write(element('h1', self.title()))
+        for name in pages[p]:
+            self.write('<div class="xref-name">')
+            self.process_name(name)
+            self.write('</div>')
+        self.end_file()
 
     def register_filenames(self):
         """Registers each view"""
@@ -172,7 +179,7 @@ class XRef(View):
         """Overrides end_file to provide synopsis logo"""
 
         self.write('\n')
-        now = time.strftime(r'%c', time.localtime(time.time()))
+        now = time.strftime(r'%c', time.localtime(self.processor.start_time))
         logo = img(src=rel(self.filename(), 'synopsis.png'), alt='logo')
         logo = href('http://synopsis.fresco.org', logo + ' synopsis', target='_blank')
         logo += ' (version %s)'%config.version
@@ -13,6 +13,8 @@ from Synopsis.DocString import DocString
 from Synopsis.FileTree import make_file_tree
 from Synopsis.Formatters.TOC import TOC
 from Synopsis.Formatters.ClassTree import ClassTree
+from Synopsis.Formatters.MarkupCache import MarkupCache
+from Synopsis.Formatters.OutputManifest import OutputManifest
 from DirectoryLayout import *
 from XRefPager import XRefPager
 from Views import *
@@ -27,12 +29,12 @@ except ImportError:
 import Markup
 import Tags
 
-import time
+import os, time, tempfile, shutil
 
 class DocCache:
     """"""
 
-    def __init__(self, processor, markup_formatters):
+    def __init__(self, processor, markup_formatters, markup_cache = None):
 
         self._processor = processor
         self._markup_formatters = markup_formatters
@@ -42,42 +44,50 @@ class DocCache:
         for f in self._markup_formatters.values():
             f.init(self._processor)
         self._doc_cache = {}
+        self.markup_cache = markup_cache
 
 
-    def _process(self, decl, view):
-        """Return the documentation for the given declaration."""
+    def _process(self, decl):
+        """Return the documentation for the given declaration. It is
+        formatted once, with links in symbolic form, so it can be used
+        by all views."""
 
         key = id(decl)
-        if key not in self._doc_cache:
+        doc = self._doc_cache.get(key)
+        if doc is None:
             doc = decl.annotations.get('doc')
             if doc:
                 formatter = self._markup_formatters.get(doc.markup,
                                                         self._markup_formatters[''])
-                doc = formatter.format(decl, view)
+                if self.markup_cache:
+                    doc = self.markup_cache.format(formatter, decl, None)
+                else:
+                    doc = formatter.format(decl, None)
             else:
                 doc = Markup.Struct()
-
-            # FIXME: Unfortunately we can't easily cache these, as they may
-            #        contain relative URLs that aren't valid across views.
-            # self._doc_cache[key] = doc
-            return doc
-        else:
-            return self._doc_cache[key]
+            self._doc_cache[key] = doc
+        return doc
 
     def doc(self, decl, view):
+        """Return the documentation for the given declaration,
+        with links relative to the given view."""
 
-        return self._process(decl, view)
+        doc = self._process(decl)
+        if not doc.summary and not doc.details: return doc
+        filename = view.filename()
+        return Markup.Struct(Markup.resolve_links(doc.summary, filename),
+                             Markup.resolve_links(doc.details, filename))
 
     def summary(self, decl, view):
         """"""
 
-        return self.doc(decl, view).summary
+        return Markup.resolve_links(self._process(decl).summary, view.filename())
 
 
     def details(self, decl, view):
         """"""
 
-        return self.doc(decl, view).details
+        return Markup.resolve_links(self._process(decl).details, view.filename())
 
 
 class Formatter(Processor):
@@ -106,6 +116,8 @@ class Formatter(Processor):
                                    'reStructuredText':RST()},
                                   'Markup-specific formatters.')
     graph_color = Parameter('#ffcc99', 'base color for inheritance graphs')
+    graph_cache = Parameter('', 'directory in which to cache rendered inheritance graphs across runs')
+    markup_cache = Parameter('', 'file in which to cache formatted documentation across runs')
     struct_as_class = Parameter(False, 'Fuse structs and classes into the same section.') 
     group_as_section = Parameter(True, 'Map group to section, instead of keeping it as a single declaration.')
 
@@ -113,8 +125,13 @@ class Formatter(Processor):
 
         self.set_parameters(kwds)
         if not self.output: raise MissingArgument('output')
+        if self.output_is_current(ir):
+            if self.verbose: print "'%s' is up to date"%self.output
+            return ir
 
         self.ir = self.merge_input(ir)
+        # All views report the same generation time.
+        self.start_time = time.time()
         # Make sure we operate on a single top-level node.
         # (Python package, C++ global namespace, etc.)
         if (len(self.ir.asg.declarations) != 1 or
@@ -126,7 +143,8 @@ class Formatter(Processor):
             self.root = self.ir.asg.declarations[0]
 
         self.directory_layout.init(self)
-        self.documentation = DocCache(self, self.markup_formatters)
+        markup_cache = self.markup_cache and MarkupCache(self.markup_cache) or None
+        self.documentation = DocCache(self, self.markup_formatters, markup_cache)
 
         # Create the class tree (shared by inheritance graph / tree views).
         self.class_tree = ClassTree()
@@ -171,15 +189,36 @@ class Formatter(Processor):
    
         if self.verbose: print "HTML Formatter: Generating views..."
 
+        # Views render into memory, and only pages that changed since
+        # the last run are written. The 'Generated on' timestamp alone
+        # doesn't count as a change.
+        now = time.strftime(r'%c', time.localtime(self.start_time))
+        self.output_files = OutputManifest(os.path.join(self.output, '.synopsis-digests'),
+                                           self.output, now)
         # Process the views.
         if len(frames) > 1:
             frameset = FrameSet()
-            frameset.process(self.output, self.directory_layout.index(),
+            frameset.process(self.output_files, self.directory_layout.index(),
                              self.title,
                              self.index[0].root()[0] or self.index[0].filename(),
                              self.detail[0].root()[0] or self.detail[0].filename(),
                              self.content[0].root()[0] or self.content[0].filename())
-        for frame in frames: frame.process()
+        # Rendered graphs are cached by content. Without a persistent
+        # cache, a temporary one is used for this run.
+        self.graphs = self.graph_cache or tempfile.mkdtemp()
+        try:
+            for frame in frames: frame.process()
+        finally:
+            if not self.graph_cache: shutil.rmtree(self.graphs, True)
+        self.output_files.finish()
+        if self.verbose or self.profile:
+            print 'Output: %s'%self.output_files.report()
+        if markup_cache:
+            markup_cache.save()
+            if self.verbose or self.profile:
+                print 'Markup cache: %d hits, %d misses'%(markup_cache.hits,
+                                                          markup_cache.misses)
+        self.record_output()
         return self.ir
 
     def has_view(self, name):
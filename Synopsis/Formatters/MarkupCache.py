@@ -0,0 +1,115 @@
+#
+# Copyright (C) 2011 Stefan Seefeld
+# All rights reserved.
+# Licensed to the public under the terms of the GNU LGPL (>= 2),
+# see the file COPYING for details.
+#
+
+"""Persistent cache of formatted documentation.
+
+Formatting a doc-string (notably reStructuredText) can be expensive, while
+doc-strings rarely change from one run to the next. The cache stores the
+formatted result under the markup type, the formatter (class and version)
+and the doc-string text. As the result also depends on the symbols the
+doc-string refers to, the symbol lookups made while formatting are
+recorded with their results, and an entry is only reused if all of them
+still give the same results."""
+
+from Synopsis import config
+import os, os.path, tempfile
+import cPickle
+
+class MarkupCache(object):
+
+    variants = 4
+    """Maximum number of results kept per doc-string, such as for the
+    same text attached to declarations in different scopes."""
+
+    def __init__(self, filename):
+
+        self.filename = filename
+        self.entries = {}
+        self._updates = {}
+        self.hits = self.misses = 0
+        if os.path.exists(filename):
+            self.entries = self._load()
+
+    def _load(self):
+
+        file = open(self.filename, 'rb')
+        try:
+            return cPickle.load(file)
+        finally:
+            file.close()
+
+    def key(self, formatter, doc):
+
+        cls = formatter.__class__
+        return ('%s.%s'%(cls.__module__, cls.__name__),
+                config.version, getattr(formatter, 'version', ''),
+                doc.markup, doc.text)
+
+    def format(self, formatter, decl, *args):
+        """Return the documentation of 'decl' formatted by 'formatter',
+        either from the cache, or by calling 'formatter.format(decl, *args)'."""
+
+        key = self.key(formatter, decl.annotations['doc'])
+        for lookups, result in self.entries.get(key, ()):
+            for symbol, scope, target in lookups:
+                if formatter.lookup_symbol(symbol, scope) != target:
+                    break
+            else:
+                self.hits += 1
+                return result
+
+        self.misses += 1
+        lookups = []
+        def lookup_symbol(symbol, scope):
+            target = lookup(symbol, scope)
+            lookups.append((symbol, scope, target))
+            return target
+        lookup = formatter.lookup_symbol
+        formatter.lookup_symbol = lookup_symbol
+        try:
+            result = formatter.format(decl, *args)
+        finally:
+            del formatter.lookup_symbol
+        variants = [(tuple(lookups), result)] + self.entries.get(key, [])
+        self.entries[key] = variants[:self.variants]
+        self._updates[key] = self.entries[key]
+        return result
+
+    def updates(self):
+        """Return the entries added since the last call, and forget them.
+        This allows entries added in a worker process to be passed back
+        to the main process."""
+
+        updates, self._updates = self._updates, {}
+        return updates
+
+    def merge(self, updates):
+        """Add entries returned by updates() in another process."""
+
+        self.entries.update(updates)
+        self._updates.update(updates)
+
+    def save(self):
+        """Store the cache, if anything changed. Entries stored by other
+        processes in the meantime are preserved."""
+
+        if not self._updates: return
+        entries = {}
+        if os.path.exists(self.filename):
+            entries = self._load()
+        entries.update(self._updates)
+        self.entries, self._updates = entries, {}
+
+        directory = os.path.dirname(self.filename)
+        if directory and not os.path.isdir(directory):
+            os.makedirs(directory)
+        fd, tmp = tempfile.mkstemp(dir=directory or '.')
+        file = os.fdopen(fd, 'wb')
+        cPickle.dump(entries, file, 2)
+        file.close()
+        os.chmod(tmp, 0644)
+        os.rename(tmp, self.filename)
@@ -0,0 +1,190 @@
+#
+# Copyright (C) 2011 Stefan Seefeld
+# All rights reserved.
+# Licensed to the public under the terms of the GNU LGPL (>= 2),
+# see the file COPYING for details.
+#
+
+"""Skip-unchanged writing of output files.
+
+Formatters generating many files (such as the HTML formatter) render each
+file into memory, and hand it to an `OutputManifest`. The manifest records
+the digest of every file written in a run. A later run only writes the
+files whose content changed, leaving the others (and their modification
+times) untouched. Text that changes with every run, such as a timestamp,
+may be declared volatile, to be ignored when comparing. Changed files are
+written to a temporary file that is synced to disk and then renamed, so
+readers never see partial content.
+Files recorded in the previous run but not generated any more are removed."""
+
+from Synopsis.Formatters import make_dirs
+import os, os.path, tempfile
+import cPickle
+try:
+    import hashlib
+    md5 = hashlib.md5
+except ImportError:
+    # 2.4 compatibility
+    import md5
+    md5 = md5.new
+
+class Output(object):
+    """An in-memory output stream, handed to the manifest when closed."""
+
+    def __init__(self, manifest, path, encoding = None):
+
+        self.manifest = manifest
+        self.path = path
+        self.encoding = encoding
+        self.chunks = []
+
+    def write(self, text):
+
+        if self.encoding and isinstance(text, unicode):
+            text = text.encode(self.encoding)
+        self.chunks.append(text)
+
+    def writelines(self, lines):
+
+        for l in lines: self.write(l)
+
+    def flush(self):
+
+        pass
+
+    def close(self):
+
+        if self.chunks is not None:
+            self.manifest.write(self.path, ''.join(self.chunks))
+            self.chunks = None
+
+
+class OutputManifest(object):
+
+    def __init__(self, filename, base, volatile = None):
+        """Create a manifest stored in 'filename', for files in the
+        'base' directory. Occurrences of the 'volatile' string don't
+        count as changes."""
+
+        self.filename = filename
+        self.base = base
+        self.volatile = volatile
+        self.previous = {}
+        """Map from (relative) filename to digest, as of the previous run."""
+        self.current = {}
+        """Map from (relative) filename to digest, as of this run."""
+        self.written = self.skipped = self.removed = 0
+        if os.path.exists(filename):
+            file = open(filename, 'rb')
+            try:
+                self.previous = cPickle.load(file)
+            finally:
+                file.close()
+
+    def open(self, path, encoding = None):
+        """Return a stream for the file 'path', which is written (if
+        necessary) once the stream is closed."""
+
+        return Output(self, path, encoding)
+
+    def write(self, path, data):
+        """Write 'data' into the file 'path', unless it holds that
+        content already."""
+
+        key = os.path.normpath(path)
+        if os.path.isabs(key):
+            key = os.path.normpath(os.path.relpath(key, self.base))
+        filename = os.path.join(self.base, key)
+        if self.volatile:
+            digest = md5(data.replace(self.volatile, '')).hexdigest()
+        else:
+            digest = md5(data).hexdigest()
+        current = self._is_current(key, filename, digest, data)
+        self.current[key] = digest
+        if current:
+            self.skipped += 1
+            return
+
+        directory = os.path.dirname(filename)
+        make_dirs(directory)
+        fd, tmp = tempfile.mkstemp(dir=directory or '.')
+        try:
+            os.write(fd, data)
+            os.fsync(fd)
+        finally:
+            os.close(fd)
+        os.chmod(tmp, 0644)
+        os.rename(tmp, filename)
+        self.written += 1
+
+    def _is_current(self, key, filename, digest, data):
+
+        # Some views write the same file more than once per run, so
+        # compare with the last version written.
+        if key in self.current:
+            return self.current[key] == digest
+        if key in self.previous:
+            return self.previous[key] == digest and os.path.exists(filename)
+        # The file wasn't recorded (for example, it was generated before
+        # the manifest existed), so compare the actual content.
+        try:
+            if os.path.getsize(filename) != len(data):
+                return False
+        except OSError:
+            return False
+        return open(filename, 'rb').read() == data
+
+    def updates(self):
+        """Return the files written since the last call, and forget them.
+        This allows files written in a worker process to be reported
+        back to the main process."""
+
+        updates = (self.current, self.written, self.skipped)
+        self.current = {}
+        self.written = self.skipped = 0
+        return updates
+
+    def merge(self, updates):
+        """Add files returned by updates() in another process."""
+
+        current, written, skipped = updates
+        self.current.update(current)
+        self.written += written
+        self.skipped += skipped
+
+    def finish(self):
+        """Remove the files generated by the previous run but not by this
+        one, and store the manifest."""
+
+        for key in self.previous:
+            if key in self.current: continue
+            filename = os.path.join(self.base, key)
+            try:
+                os.remove(filename)
+                self.removed += 1
+            except OSError:
+                continue
+            # Remove directories left empty.
+            directory = os.path.dirname(key)
+            while directory:
+                try:
+                    os.rmdir(os.path.join(self.base, directory))
+                except OSError:
+                    break
+                directory = os.path.dirname(directory)
+        self.previous = self.current
+
+        directory = os.path.dirname(self.filename)
+        make_dirs(directory)
+        fd, tmp = tempfile.mkstemp(dir=directory or '.')
+        file = os.fdopen(fd, 'wb')
+        cPickle.dump(self.current, file, 2)
+        file.close()
+        os.chmod(tmp, 0644)
+        os.rename(tmp, self.filename)
+
+    def report(self):
+
+        return '%d files written, %d unchanged, %d removed'%(self.written,
+                                                             self.skipped,
+                                                             self.removed)
@@ -80,6 +80,7 @@ class Formatter(Processor):
     exclude = Parameter([], 'TODO: define an exclusion mechanism (glob based ?)')
     sxr_template = Parameter(os.path.join(config.datadir, 'sxr-template.html'), 'html template to be used by the sxr.cgi script')
     stylesheet = Parameter(os.path.join(config.datadir, 'html.css'), 'stylesheet to be used')
+    database = Parameter(False, 'store the symbol table in an SQLite database (sxr.db) rather than in sxr.syn')
 
     def process(self, ir, **kwds):
 
@@ -115,8 +116,16 @@ class Formatter(Processor):
             copyfile(self.sxr_template,
                      os.path.join(self.output, 'sxr-template.html'))
             
-        # Store the SXR data only.
-        ir = IR.IR(sxr=self.ir.sxr)
-        ir.save(os.path.join(self.output, 'sxr.syn'))
+        if self.database:
+            from Synopsis.SXRDatabase import Database
+            filename = os.path.join(self.output, 'sxr.db')
+            if os.path.exists(filename): os.remove(filename)
+            db = Database(filename)
+            db.update(self.ir.sxr)
+            db.close()
+        else:
+            # Store the SXR data only.
+            ir = IR.IR(sxr=self.ir.sxr)
+            ir.save(os.path.join(self.output, 'sxr.syn'))
 
         return self.ir
@@ -46,21 +46,28 @@ def quote_name(name):
     return name
 
 
+def make_dirs(directory, mode=511):
+    """Create 'directory' and all intermediate directories, unless they
+    exist already. Other processes may be creating them concurrently."""
+
+    if directory and not os.path.isdir(directory):
+        try:
+            os.makedirs(directory, mode)
+        except OSError:
+            if not os.path.isdir(directory): raise
+
+
 def open_file(path, mode=511):
     """Open a file for writing. Create all intermediate directories."""
 
-    directory = os.path.dirname(path)
-    if directory and not os.path.isdir(directory):
-        os.makedirs(directory, mode)
+    make_dirs(os.path.dirname(path), mode)
     return open(path, 'w+')
         
 
 def open_file_with_encoding(path, enc, mode=511):
     """Open a file for writing. Create all intermediate directories."""
 
-    directory = os.path.dirname(path)
-    if directory and not os.path.isdir(directory):
-        os.makedirs(directory, mode)
+    make_dirs(os.path.dirname(path), mode)
     return codecs.open(path, 'w+', encoding=enc)
         
 
@@ -58,12 +58,17 @@ class IR(object):
                 myfile.annotations['primary'] = file.annotations['primary']
             myfile.declarations.extend(file.declarations)
             myfile.includes.extend(file.includes)
-        # fix dangling inclusions of 'old' files
-        for r in replacement:
-            for f in self.files.values():
-                for i in f.includes:
-                    if i.target == r:
-                        i.target = replacement[r]
+        # fix dangling inclusions of 'old' files.
+        # Only includes coming from 'other' can refer to its files, so
+        # index those by target and re-point them in a single pass.
+        if replacement:
+            includes = {}
+            for file in other.files.itervalues():
+                for i in file.includes:
+                    includes.setdefault(i.target, []).append(i)
+            for r in replacement:
+                for i in includes.get(r, ()):
+                    i.target = replacement[r]
 
         # merge ASG
         self.asg.merge(other.asg)
@@ -0,0 +1,197 @@
+#
+# Copyright (C) 2011 Stefan Seefeld
+# All rights reserved.
+# Licensed to the public under the terms of the GNU LGPL (>= 2),
+# see the file COPYING for details.
+#
+
+"""Dependency manifest supporting incremental rebuilds.
+
+A manifest records, for a given key (a translation unit or the output of a
+processing stage), the digests of all the files the result was generated
+from, as well as a digest of the configuration of the processor that
+generated it (see `Processor.configuration`). A later run may then reuse
+the earlier result as long as none of these files changed, and the
+processor is configured the same way.
+
+Reuse is all or nothing per key: the parsers reuse the IR of unchanged
+translation units, but the Linker and the formatters redo all their work
+as soon as any of their inputs changed. In particular, re-parsed units
+aren't spliced into the previously linked IR; the merged IR is linked
+again as a whole, which costs time linear in the size of the IR."""
+
+import os, os.path, tempfile
+import cPickle
+try:
+    import hashlib
+    md5 = hashlib.md5
+except ImportError:
+    # 2.4 compatibility
+    import md5
+    md5 = md5.new
+
+_manifests = {}
+
+def open_manifest(filename):
+    """Return the manifest stored in 'filename'. All processors in a
+    process share the same instance per file."""
+
+    filename = os.path.abspath(filename)
+    if filename not in _manifests:
+        _manifests[filename] = Manifest(filename)
+    return _manifests[filename]
+
+
+def includes(ir, filename):
+    """Return the absolute names of all files the given file includes,
+    directly or indirectly, according to the include graph in 'ir'.
+    If 'filename' isn't part of 'ir', return all files in 'ir'."""
+
+    filename = os.path.abspath(filename)
+    roots = [f for f in ir.files.values() if f.abs_name == filename]
+    if not roots:
+        return [f.abs_name for f in ir.files.values()]
+    seen = {}
+    stack = roots
+    while stack:
+        file = stack.pop()
+        if file.abs_name in seen: continue
+        seen[file.abs_name] = True
+        stack.extend([i.target for i in file.includes])
+    return seen.keys()
+
+
+class Manifest(object):
+    """A persistent record of the files results depend on."""
+
+    def __init__(self, filename):
+
+        self.filename = filename
+        """The file this manifest is stored in."""
+        self.dependencies = {}
+        """Map from key to a dictionary mapping files to their digest."""
+        self.outputs = {}
+        """Map from key to a flag indicating whether it is a stored IR."""
+        self.configurations = {}
+        """Map from key to the configuration it was generated with."""
+        self._digests = {}
+        self._updated = {}
+        if os.path.exists(filename):
+            self.dependencies, self.outputs, self.configurations = self._load()
+
+    def _load(self):
+
+        file = open(self.filename, 'rb')
+        try:
+            state = cPickle.load(file)
+        finally:
+            file.close()
+        # Manifests written without configurations have none recorded,
+        # so none of their results are considered current.
+        if len(state) == 2:
+            state = state + ({},)
+        return state
+
+    def digest(self, filename):
+        """Return the digest of the given file's content, or None if it
+        doesn't exist. Digests are only computed once per run."""
+
+        filename = os.path.abspath(filename)
+        if filename not in self._digests:
+            try:
+                self._digests[filename] = md5(open(filename, 'rb').read()).hexdigest()
+            except IOError:
+                self._digests[filename] = None
+        return self._digests[filename]
+
+    def is_current(self, key, configuration):
+        """Return True if 'key' was recorded earlier with the same
+        'configuration', still exists, and none of the files it depends
+        on changed since."""
+
+        key = os.path.abspath(key)
+        deps = self.dependencies.get(key)
+        if deps is None or not os.path.exists(self.result(key)):
+            return False
+        if self.configurations.get(key) != configuration:
+            return False
+        for f, d in deps.iteritems():
+            if self.digest(f) != d:
+                return False
+            # Inputs that are themselves recorded need to be current, too.
+            if (f != key and f in self.dependencies and
+                not self.is_current(f, self.configurations.get(f))):
+                return False
+        return True
+
+    def is_ir(self, key):
+        """Return True if the result recorded for 'key' is an IR file."""
+
+        return self.outputs.get(os.path.abspath(key), False)
+
+    def result(self, key):
+        """Return the file holding the result for 'key'. For stage outputs
+        this is the key itself, for translation units it is an IR file
+        kept next to the manifest."""
+
+        key = os.path.abspath(key)
+        if key in self.outputs:
+            return key
+        return os.path.join(self.filename + '.d', md5(key).hexdigest() + '.syn')
+
+    def record(self, key, files, configuration, is_ir = False, output = True):
+        """Record the files 'key' depends on, and the 'configuration' it
+        was generated with. If 'output' is False, 'key' is a translation
+        unit whose IR is stored in 'result(key)'."""
+
+        key = os.path.abspath(key)
+        self.dependencies[key] = dict([(os.path.abspath(f), self.digest(f))
+                                       for f in files])
+        self.configurations[key] = configuration
+        if output:
+            self.outputs[key] = is_ir
+        elif key in self.outputs:
+            del self.outputs[key]
+        self._updated[key] = True
+        # The key itself may be an input of a later stage.
+        if key in self._digests:
+            del self._digests[key]
+
+    def store(self, key, ir, files, configuration):
+        """Record the files translation unit 'key' depends on, and the
+        'configuration' it was parsed with, and store its IR for reuse in
+        later runs."""
+
+        self.record(key, files, configuration, output = False)
+        result = self.result(key)
+        if not os.path.isdir(os.path.dirname(result)):
+            os.makedirs(os.path.dirname(result))
+        ir.save(result)
+
+    def save(self):
+        """Store the manifest. Records made by other processes since this
+        manifest was loaded are preserved, unless they were updated here."""
+
+        dependencies, outputs, configurations = {}, {}, {}
+        if os.path.exists(self.filename):
+            dependencies, outputs, configurations = self._load()
+        for key in self._updated:
+            dependencies[key] = self.dependencies[key]
+            configurations[key] = self.configurations[key]
+            if key in self.outputs:
+                outputs[key] = self.outputs[key]
+            elif key in outputs:
+                del outputs[key]
+        self.dependencies, self.outputs = dependencies, outputs
+        self.configurations = configurations
+        self._updated = {}
+
+        directory = os.path.dirname(self.filename)
+        if directory and not os.path.isdir(directory):
+            os.makedirs(directory)
+        fd, tmp = tempfile.mkstemp(dir=directory or '.')
+        file = os.fdopen(fd, 'wb')
+        cPickle.dump((dependencies, outputs, configurations), file, 1)
+        file.close()
+        os.chmod(tmp, 0644)
+        os.rename(tmp, self.filename)
@@ -8,9 +8,11 @@
 #include "ASGTranslator.hh"
 #include <Support/utils.hh>
 #include <Support/path.hh>
+#include <Support/Profiler.hh>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 using namespace Synopsis;
 
@@ -34,34 +36,20 @@ void cv_qual(CXType t, bpl::list mods)
 class MacroDefinition
 {
 public:
-  MacroDefinition(CXTranslationUnit tu, CXCursor c)
+  MacroDefinition(TokenCache &cache, CXCursor c)
     : is_function_(false)
   {
-    CXToken *tokens;
-    unsigned num_tokens;
-    clang_tokenize(tu, clang_getCursorExtent(c), &tokens, &num_tokens);
-    if (!num_tokens) return;
+    TokenCache::Range tokens = cache.tokens(clang_getCursorExtent(c));
     // <macro-name> '(' <arg> [',' <args>] ')'
-    for (unsigned i = 1; i != num_tokens; ++i) 
+    for (size_t i = 1; i < tokens.size(); ++i)
     {
       is_function_ = true;
-      CXString t = clang_getTokenSpelling(tu, tokens[i]);
-      char const *s = clang_getCString(t);
       // if we see a ')' it means we are done with the parameter list.
-      if (*s == ')')
-      {
-	clang_disposeString(t);
-	clang_disposeTokens(tu, tokens, num_tokens);  
-	return;
-      }
+      if (*tokens.data(i) == ')') return;
       // every other token is punktuation: '(' ','...')'
       else if (!(i%2))
-      {
-	parameters_.append(s);
-      }
-      clang_disposeString(t);
+	parameters_.append(tokens.spelling(i));
     }
-    clang_disposeTokens(tu, tokens, num_tokens);  
   }
 
   bool is_function() const { return is_function_;}
@@ -75,7 +63,7 @@ private:
 class Stringifier
 {
 public:
-  Stringifier(CXTranslationUnit tu) : tu_(tu) {}
+  Stringifier(TokenCache &cache) : cache_(cache) {}
   std::string stringify(CXCursor parent)
   {
     value_ = "";
@@ -87,15 +75,11 @@ private:
   static CXChildVisitResult visit(CXCursor c, CXCursor p, CXClientData d)
   {
     Stringifier *stringifier = static_cast<Stringifier *>(d);
-
-    CXString k = clang_getCursorKindSpelling(c.kind);
-    std::string kind = clang_getCString(k);
-    clang_disposeString(k);
-    stringifier->value_ += stringify_range(stringifier->tu_, clang_getCursorExtent(c));
+    stringifier->value_ += stringifier->cache_.stringify(clang_getCursorExtent(c));
     return CXChildVisit_Continue;
   }
 
-  CXTranslationUnit tu_;
+  TokenCache &cache_;
   std::string value_;
 };
 
@@ -177,7 +161,7 @@ TypeRepository::TypeRepository(bpl::dict types, bool verbose)
   bpl::object qname_module = bpl::import("Synopsis.QualifiedName");
   qname_ = qname_module.attr("QualifiedCxxName");  
 
-#define DECLARE_BUILTIN_TYPE(T) types_[qname(T)] = asg_module_.attr("BuiltinTypeId")("C", qname(T))
+#define DECLARE_BUILTIN_TYPE(T) types_[qname(T)] = intern(asg_module_.attr("BuiltinTypeId")("C", qname(T)))
 
   DECLARE_BUILTIN_TYPE("bool");
   DECLARE_BUILTIN_TYPE("char");
@@ -250,7 +234,7 @@ bpl::object TypeRepository::lookup(CXType t) const
       cv_qual(i, postmod);
       postmod.append("&");
       bpl::object inner = lookup(i);
-      return asg_module_.attr("ModifierTypeId")("C", inner, bpl::list(), postmod);
+      return intern(asg_module_.attr("ModifierTypeId")("C", inner, bpl::list(), postmod));
     }
     case CXType_Pointer:
     {
@@ -259,7 +243,7 @@ bpl::object TypeRepository::lookup(CXType t) const
       cv_qual(i, postmod);
       postmod.append("*");
       bpl::object inner = lookup(i);
-      return asg_module_.attr("ModifierTypeId")("C", inner, bpl::list(), postmod);
+      return intern(asg_module_.attr("ModifierTypeId")("C", inner, bpl::list(), postmod));
     }
     case CXType_Unexposed:
     {
@@ -281,6 +265,7 @@ bpl::object TypeRepository::lookup(CXType t) const
 ASGTranslator::ASGTranslator(std::string const &filename,
 			     std::string const &base_path, bool primary_file_only,
 			     bpl::object asg, bpl::dict files,
+			     std::string const &comment_filter,
 			     bool v, bool d)
   : asg_module_(bpl::import("Synopsis.ASG")),
     sf_module_(bpl::import("Synopsis.SourceFile")),
@@ -289,6 +274,7 @@ ASGTranslator::ASGTranslator(std::string const &filename,
     primary_filename_(filename),
     primary_file_only_(primary_file_only),
     base_path_(base_path),
+    comment_filter_(comment_filter),
     verbose_(v),
     debug_(d)
 {
@@ -313,6 +299,7 @@ ASGTranslator::ASGTranslator(std::string const &filename,
 void ASGTranslator::translate(CXTranslationUnit tu)
 {
   tu_ = tu; // save to make tu accessible elsewhere (tokenization)
+  tokens_.reset(tu);
   CXFile f = clang_getFile(tu, primary_filename_.c_str());
   comment_horizon_ = clang_getLocationForOffset(tu, f, 0);
   // prev_cursor_.push(clang_getNullCursor())
@@ -369,6 +356,7 @@ void ASGTranslator::declare(CXCursor c, bpl::object d)
     declarations_.append(d);
   bpl::extract<bpl::list>(file_.attr("declarations"))().append(d);
   symbols_.declare(c, d);
+  Profiler::count("objects");
 }
 
 bpl::object ASGTranslator::create(CXCursor c)
@@ -429,7 +417,7 @@ bpl::object ASGTranslator::create(CXCursor c)
     }
     case CXCursor_MacroDefinition:
     {
-      MacroDefinition definition(tu_, c);
+      MacroDefinition definition(tokens_, c);
       return asg_module_.attr("Macro")(source_file, line,
 				       "macro", // type
 				       qname(name),
@@ -447,7 +435,7 @@ bpl::object ASGTranslator::create(CXCursor c)
     }
     case CXCursor_EnumConstantDecl:
     {
-      Stringifier stringifier(tu_);
+      Stringifier stringifier(tokens_);
       bpl::object value(stringifier.stringify(c));
       return asg_module_.attr("Enumerator")(source_file, line, qname(name), value);
     }
@@ -465,7 +453,7 @@ bpl::object ASGTranslator::create(CXCursor c)
       if (stype == "struct" || stype == "union") vtype = "data member";
       if (is_const)
       {
-	Stringifier stringifier(tu_);
+	Stringifier stringifier(tokens_);
 	bpl::object value(stringifier.stringify(c));
 	return asg_module_.attr("Const")(source_file, line, vtype, qname(name), type, value);
       }
@@ -640,7 +628,13 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
   // In addition, if the given cursor is separated from preceding comments by an
   // empty line, an empty item is pushed into the list, to allow comment-processors
   // to take this into account during filtering.
-  bpl::list comments;
+  //
+  // Comments the comment filter rejects are replaced by None, without ever
+  // being converted to Python strings.
+  //
+  // As comments are found walking backwards, they are collected in reverse order.
+  std::vector<std::string> comments;
+  bool separated = false;
   bool next_is_cxx_comment = false;
   unsigned next_token_start_line;
   clang_getSpellingLocation(clang_getRangeStart(clang_getCursorExtent(c)),
@@ -654,6 +648,7 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
   CXToken *tokens;
   unsigned num_tokens;
   clang_tokenize(tu_, range, &tokens, &num_tokens);
+  Profiler::count("tokens", num_tokens);
   // FIXME: Due to a bug in clang_tokenize, the last token returned is actually outside
   //        the range
   if (num_tokens) --num_tokens;
@@ -673,7 +668,7 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
     //        to be empty (and thus can't be seen by the extent-computing machinery.
     //
     //        As a simple heuristic (and until we find a better solution), ignore such tokens.
-    if (kind == CXToken_Identifier && bpl::len(comments) == 0)
+    if (kind == CXToken_Identifier && comments.empty())
     {
       // look it up to see whether it is actually part of a macro instantiation (and defines to nothing).
       //...
@@ -690,21 +685,19 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
 			      0, &prev_token_end_line, 0, 0);
     // If the comment directly preceding the cursor is separated from it by
     // an empty line, insert an empty string into the comments.
-    if (bpl::len(comments) == 0 &&
+    if (comments.empty() &&
 	prev_token_end_line + 1 != next_token_start_line)
-      comments.append("");
+      separated = true;
 
     // If two consecutive comments are both C++-style and are only separated by
     // a single newline, concatenate them.
     if (prev_token_end_line + 1 == next_token_start_line &&
 	is_cxx_comment && next_is_cxx_comment)
     {
-      std::string comment = bpl::extract<std::string>(comments[0]);
-      comment.insert(0, "\n");
-      comment.insert(0, text);
-      comments[0] = comment;
+      comments.back().insert(0, 1, '\n');
+      comments.back().insert(0, text);
     }
-    else comments.insert(0, text);
+    else comments.push_back(text);
 
     clang_disposeString(s);
 
@@ -713,7 +706,16 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
 			      0, &next_token_start_line, 0, 0);
   }
   clang_disposeTokens(tu_, tokens, num_tokens);
-  return comments;
+  bpl::list result;
+  for (std::vector<std::string>::reverse_iterator i = comments.rbegin();
+       i != comments.rend();
+       ++i)
+  {
+    if (comment_filter_.accept(*i)) result.append(*i);
+    else result.append(bpl::object());
+  }
+  if (separated) result.append("");
+  return result;
 }
 
 CXChildVisitResult ASGTranslator::visit(CXCursor c, CXCursor p, CXClientData d)
@@ -721,6 +723,7 @@ CXChildVisitResult ASGTranslator::visit(CXCursor c, CXCursor p, CXClientData d)
   ASGTranslator *translator = static_cast<ASGTranslator*>(d);
   if (translator->verbose_)
     std::cout << "visit " << cursor_info(c) << std::endl;
+  Profiler::count("cursors");
 
   try
   {
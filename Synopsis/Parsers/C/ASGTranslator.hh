@@ -10,6 +10,8 @@
 
 #include <boost/python.hpp>
 #include <clang-c/Index.h>
+#include <Support/CommentFilter.hh>
+#include <Support/TokenCache.hh>
 #include <stack>
 #include <map>
 
@@ -51,6 +53,8 @@ public:
 
 private:
   bpl::object qname(std::string const &name) const { return qname_(bpl::make_tuple(name));}
+  //. Return the shared type-id equal to the given one (see ASG.intern_type_id).
+  bpl::object intern(bpl::object type) const { return asg_module_.attr("intern_type_id")(type);}
 
   bpl::object asg_module_;
   bpl::object qname_;
@@ -64,7 +68,8 @@ class ASGTranslator
 public:
   ASGTranslator(std::string const &filename,
 		std::string const &base_path, bool primary_file_only,
-		bpl::object asg, bpl::dict files, bool v, bool d);
+		bpl::object asg, bpl::dict files,
+		std::string const &comment_filter, bool v, bool d);
 
   void translate(CXTranslationUnit);
 
@@ -90,6 +95,7 @@ private:
   static CXChildVisitResult visit(CXCursor c, CXCursor p, CXClientData d);
 
   CXTranslationUnit tu_;
+  Synopsis::TokenCache tokens_;
   bpl::object       qname_;
   bpl::object       asg_module_;
   bpl::object       sf_module_;
@@ -109,6 +115,7 @@ private:
   std::string       primary_filename_;
   bool              primary_file_only_;
   std::string       base_path_;
+  Synopsis::CommentFilter comment_filter_;
   bool              verbose_;
   bool              debug_;
 };
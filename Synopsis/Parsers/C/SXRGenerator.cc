@@ -6,15 +6,18 @@
 //
 #include "SXRGenerator.hh"
 #include <Support/utils.hh>
+#include <Support/Profiler.hh>
+#include <Support/LineTable.hh>
 #include <cstring>
-#include <boost/filesystem/operations.hpp>
+#include <fstream>
+#include <iterator>
 #include <sstream>
 #include <iostream>
 
-namespace fs = boost::filesystem;
-
-SXRGenerator::SXRGenerator(ASGTranslator const &t, bool v, bool d)
+SXRGenerator::SXRGenerator(ASGTranslator const &t, std::string const &format,
+                           bool v, bool d)
   : translator_(t),
+    format_(format),
     verbose_(v),
     debug_(d)
 {
@@ -24,11 +27,17 @@ void SXRGenerator::generate(CXTranslationUnit tu,
 			    std::string const &sxr, std::string const &abs_filename, std::string const &filename)
 {
   tu_ = tu;
-  obuf_.open(sxr.c_str(), std::ios_base::out);
+  writer_.reset(Synopsis::SXR::make_writer(format_, sxr, filename));
   // FIXME: This function is broken. Construct the range manually instead...
   // CXSourceRange range = clang_getCursorExtent(clang_getTranslationUnitCursor(tu));
-  fs::path path(abs_filename);
-  size_t size = fs::file_size(path);
+  // Lines and columns are looked up in a table of line start offsets,
+  // so only the offset of each token needs to be asked for.
+  std::ifstream ifs(abs_filename.c_str(), std::ios::in | std::ios::binary);
+  if (!ifs) throw std::runtime_error("unable to open " + abs_filename);
+  std::string source((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+  Synopsis::LineTable lines(source.data(), source.data() + source.size());
+  size_t size = source.size();
   CXFile f = clang_getFile(tu, abs_filename.c_str());
   CXSourceLocation begin = clang_getLocationForOffset(tu, f, 0);
   CXSourceLocation end = clang_getLocationForOffset(tu, f, size);
@@ -37,10 +46,7 @@ void SXRGenerator::generate(CXTranslationUnit tu,
   CXToken *tokens;
   unsigned num_tokens;
   clang_tokenize(tu, range, &tokens, &num_tokens);
-  write("<sxr filename=\"");
-  write(filename.c_str());
-  write("\">\n");
-  write("<line>");
+  Synopsis::Profiler::count("tokens", num_tokens);
 
   // Why does clang start counting at '1' ?
   unsigned line = 1, column = 1;
@@ -49,11 +55,13 @@ void SXRGenerator::generate(CXTranslationUnit tu,
     // CXSourceRange extent = clang_getTokenExtent(tu, tokens[i]);
     // CXSourceLocation start = clang_getRangeStart(extent);
     CXSourceLocation start = clang_getTokenLocation(tu, tokens[i]);
-    unsigned l, c;
-    clang_getSpellingLocation(start, 0, &l, &c, 0);
+    unsigned offset;
+    clang_getSpellingLocation(start, 0, 0, 0, &offset);
+    unsigned l = lines.line(offset, line);
+    unsigned c = lines.column(offset, l);
     if (l > line) column = 1;
-    while (l > line) { write("</line>\n<line>"); ++line;}
-    while (c > column) { obuf_.sputc(' '); ++column;}
+    while (l > line) { writer_->newline(); ++line;}
+    if (c > column) { writer_->space(c - column); column = c;}
     //  Now fill the output buffer till the given location (l,c)
     CXString token_string = clang_getTokenSpelling(tu, tokens[i]);
     char const *s = clang_getCString(token_string);
@@ -66,25 +74,21 @@ void SXRGenerator::generate(CXTranslationUnit tu,
 	break;
       case CXToken_Keyword:
       case CXToken_Literal:
-	write("<span class=\"");
-	write(token_kind_to_class(kind));
-	write("\">");
-	write_esc(s);
-	write("</span>");
+	writer_->span(token_kind_to_class(kind), s, len);
 	break;
       case CXToken_Identifier:
-	write_xref(tokens[i]);
+	write_xref(start, s, len);
 	break;
       default:
-	write_esc(s);
+	writer_->text(s, len);
 	break;
     }
     clang_disposeString(token_string);
     column += len;
   }
-  write("</line>\n</sxr>\n");
   clang_disposeTokens(tu, tokens, num_tokens);
-  obuf_.close();
+  writer_->close();
+  writer_.reset();
 }
 
 char const *SXRGenerator::token_kind_to_class(CXTokenKind k)
@@ -131,28 +135,22 @@ std::string SXRGenerator::from(CXCursor c)
 
 void SXRGenerator::write_comment(std::string const &comment, unsigned &line)
 {
-  write("<span class=\"comment\">");
   // If the comment contains newlines, we need to write it in chunks
   std::string::size_type begin = 0, end = comment.find('\n');
   while (end != std::string::npos)
   {
-    write_esc(comment.substr(begin, end - begin));
-    write("</span></line>\n");
-    write("<line><span class=\"comment\" continuation=\"true\">");
+    writer_->span("comment", comment.data() + begin, end - begin, begin != 0);
+    writer_->newline();
     ++line;
     begin = end + 1;
     end = comment.find('\n', begin);
   }
-  write_esc(comment.substr(begin));
-  write("</span>");
+  writer_->span("comment", comment.data() + begin, comment.size() - begin, begin != 0);
 }
 
-void SXRGenerator::write_xref(CXToken const &t)
+void SXRGenerator::write_xref(CXSourceLocation l, char const *s, size_t len)
 {
-  CXSourceLocation l = clang_getTokenLocation(tu_, t);
-  CXString s = clang_getTokenSpelling(tu_, t);
-  std::string text = clang_getCString(s);
-  clang_disposeString(s);
+  std::string text(s, len);
   CXCursor c = clang_getCursor(tu_, l);
   CXCursor r = clang_getCursorReferenced(c);
   if (clang_isCursorDefinition(c) ||
@@ -161,79 +159,19 @@ void SXRGenerator::write_xref(CXToken const &t)
   {
     std::string xref = this->xref(c);
     if (!xref.empty())
-    {
-      write("<a href=\"");
-      write_esc(xref);
-      std::string from = this->from(clang_getCursorSemanticParent(c));
-      if (!from.empty())
-      {
-	write("\" from=\"");
-	write_esc(from);
-      }
-      write("\" type=\"definition\">");
-      write_esc(text);
-      write("</a>");
-    }
+      writer_->anchor(xref, this->from(clang_getCursorSemanticParent(c)),
+                      "definition", text.data(), text.size());
     else
-      write_esc(text);
+      writer_->text(text);
   }
   else if (!clang_equalCursors(r, c))
   {
     std::string xref = this->xref(r);
     if (!xref.empty())
-    {
-      write("<a href=\"");
-      write_esc(xref);
-      std::string from = this->from(c);
-      if (!from.empty())
-      {
-	write("\" from=\"");
-	write_esc(from);
-      }
-      write("\" type=\"reference\">");
-      write_esc(text);
-      write("</a>");
-    }
+      writer_->anchor(xref, this->from(c), "reference", text.data(), text.size());
     else
-      write_esc(text);
+      writer_->text(text);
   }
   else 
     throw std::runtime_error("unimplemented: " + cursor_info(c));
 }
-
-void SXRGenerator::write(char const *text, size_t len)
-{
-  if (len) obuf_.sputn(text, len);
-  else obuf_.sputn(text, strlen(text));
-}
-
-void SXRGenerator::write_esc(std::string const &text)
-{
-  // output each character, escaping it as necessary
-  for (std::string::const_iterator i = text.begin(); i != text.end(); ++i)
-    switch (*i)
-    {
-      case '&': write("&amp;"); break;
-      case '<': write("&lt;"); break;
-      case '>': write("&gt;"); break;
-      case '"': write("&quot;"); break;
-      default: obuf_.sputc(*i); break;
-    }
-};
-
-void SXRGenerator::write_esc(char const *text)
-{
-  // output each character, escaping it as necessary
-  while (*text)
-  {
-    switch (*text)
-    {
-      case '&': write("&amp;"); break;
-      case '<': write("&lt;"); break;
-      case '>': write("&gt;"); break;
-      case '"': write("&quot;"); break;
-      default: obuf_.sputc(*text); break;
-    }
-    ++text;
-  }
-};
@@ -6,6 +6,7 @@
 #
 
 from Synopsis.Processor import Processor, Parameter
+from Synopsis import IR, Manifest, Profiler
 from ParserImpl import parse
 
 import os, os.path, tempfile
@@ -19,6 +20,8 @@ class Parser(Processor):
     primary_file_only = Parameter(True, 'should only primary file be processed')
     base_path = Parameter('', 'path prefix to strip off of the file names')
     sxr_prefix = Parameter(None, 'path prefix (directory) to contain sxr info')
+    sxr_format = Parameter('xml', "format of sxr files ('xml', 'binary', or 'compressed')")
+    comment_filter = Parameter('', "style of the comment filter to be used ('c', 'ss', 'ssd', 'sss', 'java', or 'qt'), to drop other comments while parsing")
 
     def process(self, ir, **kwds):
 
@@ -36,9 +39,20 @@ class Parser(Processor):
                              compiler_flags = self.compiler_flags)
 
         base_path = self.base_path and os.path.abspath(self.base_path) + os.sep or ''
+        manifest = self.get_manifest()
+        configuration = manifest and self.configuration()
 
         for file in self.input:
 
+            if manifest and manifest.is_current(file, configuration):
+                # Nothing this translation unit depends on has changed,
+                # so reuse the IR stored by an earlier run.
+                if self.verbose: print "reusing IR for '%s'"%file
+                self.ir.merge(IR.load(manifest.result(file)))
+                continue
+            # Parse into a fresh IR if it is to be stored for reuse.
+            ir = manifest and IR.IR() or self.ir
+
             i_file = file
             if self.preprocess:
 
@@ -47,25 +61,35 @@ class Parser(Processor):
                 else:
                     i_file = os.path.join(tempfile.gettempdir(),
                                           'synopsis-%s.i'%os.getpid())
-                self.ir = cpp.process(self.ir,
-                                      cpp_output = i_file,
-                                      input = [file],
-                                      primary_file_only = self.primary_file_only,
-                                      base_path = base_path,
-                                      verbose = self.verbose,
-                                      debug = self.debug,
-                                      profile = self.profile)
-
-            self.ir = parse(self.ir, i_file,
-                            os.path.abspath(file),
-                            base_path,
-                            self.primary_file_only,
-                            self.sxr_prefix,
-                            self.cppflags,
-                            self.verbose,
-                            self.debug,
-                            self.profile)
+                ir = cpp.process(ir,
+                                 cpp_output = i_file,
+                                 input = [file],
+                                 primary_file_only = self.primary_file_only,
+                                 base_path = base_path,
+                                 verbose = self.verbose,
+                                 debug = self.debug,
+                                 profile = self.profile)
+
+            ir = parse(ir, i_file,
+                       os.path.abspath(file),
+                       base_path,
+                       self.primary_file_only,
+                       self.sxr_prefix,
+                       self.sxr_format,
+                       self.comment_filter,
+                       self.cppflags,
+                       self.verbose,
+                       self.debug,
+                       Profiler.enabled())
 
             if self.preprocess: os.remove(i_file)
 
+            if manifest:
+                manifest.store(file, ir, Manifest.includes(ir, file), configuration)
+                self.ir.merge(ir)
+            else:
+                self.ir = ir
+
+        if manifest: manifest.save()
+
         return self.output_and_return_ir()
@@ -16,6 +16,7 @@
 #include <boost/wave/preprocessing_hooks.hpp>
 #include <stack>
 #include <Support/path.hh>
+#include <Support/Profiler.hh>
 
 using namespace Synopsis;
 namespace wave = boost::wave;
@@ -214,6 +215,7 @@ void IRGenerator::rescanned_macro(Context const &ctx,
                   bpl::make_tuple(current_macro_call_end_.get_line(), current_macro_call_end_.get_column() - 1),
                   bpl::make_tuple(start.get_line(), start.get_column() - 1 + current_offset_),
                   bpl::make_tuple(start.get_line(), start.get_column() - 1 + tmp.size() + current_offset_)));
+    Profiler::count("objects");
     current_offset_ += start.get_column() + tmp.size() - 1 - current_macro_call_end_.get_column();
   }
 }
@@ -247,6 +249,7 @@ void IRGenerator::opened_include_file(Context const &ctx,
                                                    include_next_dir_);
   bpl::list includes = bpl::extract<bpl::list>(file_stack_.top().attr("includes"));
   includes.append(include);
+  Profiler::count("objects");
   file_stack_.push(source_file);
   
   std::string abs_filename = make_full_path(relname);
@@ -317,6 +320,7 @@ void IRGenerator::defined_macro(Context const &ctx,
   bpl::object declared = asg_module_.attr("DeclaredTypeId")(language_, qname, macro);
   declarations_.append(macro);
   types_[qname] = declared;
+  Profiler::count("objects", 3);
 }
 
 inline
@@ -336,6 +340,7 @@ bpl::object IRGenerator::lookup_source_file(std::string const &filename,
     source_file = sf_module_.attr("SourceFile")(short_name, long_name,
                                                 language_, primary);
     files_[short_name] = source_file;
+    Profiler::count("objects");
   }
   else if (primary)
   {
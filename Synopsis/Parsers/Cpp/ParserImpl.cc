@@ -7,7 +7,7 @@
 
 #include <boost/version.hpp>
 #include <boost/python.hpp>
-#include <Support/Timer.hh>
+#include <Support/PythonProfiler.hh>
 #include "IRGenerator.hh"
 #include <memory>
 #include <sstream>
@@ -61,7 +61,7 @@ bpl::object parse(bpl::object ir,
   std::string input(std::istreambuf_iterator<char>(ifs.rdbuf()),
                     std::istreambuf_iterator<char>());
 
-  Timer timer;
+  ProfileSubmitter submitter(profile);
 
   IRGenerator generator(language, input_file, base_path, primary_file_only,
                         ir, verbose, debug);
@@ -153,24 +153,26 @@ bpl::object parse(bpl::object ir,
     }
   }
 
-  IRGenerator::Context::iterator_type first = ctx.begin();
-  IRGenerator::Context::iterator_type end = ctx.end();
-
-  for (std::vector<std::string>::const_reverse_iterator i = includes.rbegin(),
-         e = includes.rend();
-       i != e; /**/)
   {
-    std::string filename(*i);
-    first.force_include(filename.c_str(), ++i == e);
-  }
+    Profiler::Zone zone("preprocessor");
+    IRGenerator::Context::iterator_type first = ctx.begin();
+    IRGenerator::Context::iterator_type end = ctx.end();
 
-  while (first != end)
-  {
-    ofs << (*first).get_value();
-    ++first;
+    for (std::vector<std::string>::const_reverse_iterator i = includes.rbegin(),
+           e = includes.rend();
+         i != e; /**/)
+    {
+      std::string filename(*i);
+      first.force_include(filename.c_str(), ++i == e);
+    }
+
+    while (first != end)
+    {
+      ofs << (*first).get_value();
+      ++first;
+      Profiler::count("tokens");
+    }
   }
-  if (profile)
-    std::cout << "preprocessor took " << timer.elapsed() << " seconds" << std::endl;
   return ir;
 }
 
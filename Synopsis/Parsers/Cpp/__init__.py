@@ -8,6 +8,7 @@
 """Preprocessor for C, C++, IDL"""
 
 from Synopsis.Processor import *
+from Synopsis import Profiler
 from Emulator import get_compiler_info
 from ParserImpl import parse
 import os.path
@@ -54,6 +55,6 @@ class Parser(Processor):
                             self.cpp_output,
                             self.language, system_flags, flags,
                             self.primary_file_only,
-                            self.verbose, self.debug, self.profile)
+                            self.verbose, self.debug, Profiler.enabled())
         return self.output_and_return_ir()
 
@@ -8,9 +8,11 @@
 #include "ASGTranslator.hh"
 #include <Support/utils.hh>
 #include <Support/path.hh>
+#include <Support/Profiler.hh>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 using namespace Synopsis;
 
@@ -34,34 +36,20 @@ void cv_qual(CXType t, bpl::list mods)
 class MacroDefinition
 {
 public:
-  MacroDefinition(CXTranslationUnit tu, CXCursor c)
+  MacroDefinition(TokenCache &cache, CXCursor c)
     : is_function_(false)
   {
-    CXToken *tokens;
-    unsigned num_tokens;
-    clang_tokenize(tu, clang_getCursorExtent(c), &tokens, &num_tokens);
-    if (!num_tokens) return;
+    TokenCache::Range tokens = cache.tokens(clang_getCursorExtent(c));
     // <macro-name> '(' <arg> [',' <args>] ')'
-    for (unsigned i = 1; i != num_tokens; ++i) 
+    for (size_t i = 1; i < tokens.size(); ++i)
     {
       is_function_ = true;
-      CXString t = clang_getTokenSpelling(tu, tokens[i]);
-      char const *s = clang_getCString(t);
       // if we see a ')' it means we are done with the parameter list.
-      if (*s == ')')
-      {
-	clang_disposeString(t);
-	clang_disposeTokens(tu, tokens, num_tokens);  
-	return;
-      }
+      if (*tokens.data(i) == ')') return;
       // every other token is punktuation: '(' ','...')'
       else if (!(i%2))
-      {
-	parameters_.append(s);
-      }
-      clang_disposeString(t);
+	parameters_.append(tokens.spelling(i));
     }
-    clang_disposeTokens(tu, tokens, num_tokens);  
   }
 
   bool is_function() const { return is_function_;}
@@ -72,103 +60,48 @@ private:
 };
 
 
+//. Concatenate the source text of a cursor's children, such as the
+//. initializer of a variable.
 class Stringifier
 {
 public:
-  Stringifier(CXTranslationUnit tu) : tu_(tu) {}
-  std::string stringify(CXCursor parent)
-  {
-    value_ = "";
-    clang_visitChildren(parent, &Stringifier::visit, this);
-    return value_;
-  }
-private:
-
-  static CXChildVisitResult visit(CXCursor c, CXCursor p, CXClientData d)
-  {
-    Stringifier *stringifier = static_cast<Stringifier *>(d);
-
-    CXString k = clang_getCursorKindSpelling(c.kind);
-    std::string kind = clang_getCString(k);
-    clang_disposeString(k);
-    stringifier->value_ += stringify_range(stringifier->tu_, clang_getCursorExtent(c));
-    return CXChildVisit_Continue;
-  }
-
-  CXTranslationUnit tu_;
-  std::string value_;
-};
-
-class UsingDirectiveDereferencer
-{
-public:
-  UsingDirectiveDereferencer() {}
-  CXCursor reference(CXCursor parent)
+  Stringifier(TokenCache &cache) : cache_(cache) {}
+  std::string stringify(CursorChildren &children)
   {
-    clang_visitChildren(parent, &UsingDirectiveDereferencer::visit, this);
-    return r_;
+    std::string value;
+    CursorChildren::Cursors const &all = children.all();
+    for (CursorChildren::Cursors::const_iterator i = all.begin(); i != all.end(); ++i)
+      value += cache_.stringify(clang_getCursorExtent(*i));
+    return value;
   }
 private:
-
-  static CXChildVisitResult visit(CXCursor c, CXCursor p, CXClientData d)
-  {
-    UsingDirectiveDereferencer *visitor = static_cast<UsingDirectiveDereferencer *>(d);
-    if (c.kind == CXCursor_NamespaceRef)
-      visitor->r_ = clang_getCursorReferenced(c);
-    // The referenced name may be qualified, in which case we'll iterate over all scopes.
-    // We are interested into the last cursor in this iteration.
-    return CXChildVisit_Continue;
-  }
-
-  CXCursor r_;
+  TokenCache &cache_;
 };
 
-class BaseSpecVisitor
+class BaseSpecTranslator
 {
 public:
-  BaseSpecVisitor(TypeRepository &types)
+  BaseSpecTranslator(TypeRepository &types)
     : asg_module_(bpl::import("Synopsis.ASG")),
       types_(types)
-  {
-    bpl::object qname_module = bpl::import("Synopsis.QualifiedName");
-    qname_ = qname_module.attr("QualifiedCxxName");  
-  }
+  {}
 
-  bpl::list find_bases(CXCursor parent)
+  bpl::list translate(CursorChildren &children)
   {
-    clang_visitChildren(parent, &BaseSpecVisitor::visit, this);
-    return bases_;
-  }
-private:
-
-  bpl::object qname(std::string const &name) { return qname_(bpl::make_tuple(name));}
-  CXChildVisitResult visit(CXCursor c)
-  {
-    switch (c.kind)
+    bpl::list bases;
+    CursorChildren::Cursors const &specs = children.bases();
+    for (CursorChildren::Cursors::const_iterator i = specs.begin(); i != specs.end(); ++i)
     {
-      case CXCursor_CXXBaseSpecifier:
-      {
-	bpl::object parent = types_.lookup(clang_getCursorType(c));
-	bpl::list attributes;
-	if (clang_isVirtualBase(c))
-	  attributes.append("virtual");
-	attributes.append(access_spec(clang_getCXXAccessSpecifier(c)));
-	bases_.append(asg_module_.attr("Inheritance")("inherits", parent, attributes));
-        return CXChildVisit_Continue;
-      }
-      default:
-	// Unfortunately there is no way to only visit base specifiers,
-	// making the whole traversal rather inefficient.
-        return CXChildVisit_Continue;
+      bpl::object parent = types_.lookup(clang_getCursorType(*i));
+      bpl::list attributes;
+      if (clang_isVirtualBase(*i))
+	attributes.append("virtual");
+      attributes.append(access_spec(clang_getCXXAccessSpecifier(*i)));
+      bases.append(asg_module_.attr("Inheritance")("inherits", parent, attributes));
     }
-    // If we are here, we are past the base specifiers, and can abort.
-    return CXChildVisit_Break;
-  }
-  static CXChildVisitResult visit(CXCursor c, CXCursor p, CXClientData d)
-  {
-    BaseSpecVisitor *visitor = static_cast<BaseSpecVisitor*>(d);
-    return visitor->visit(c);
+    return bases;
   }
+private:
   static char const *access_spec(CX_CXXAccessSpecifier s)
   {
     switch (s)
@@ -181,15 +114,13 @@ private:
   };
 
   bpl::object asg_module_;
-  bpl::object qname_;
   TypeRepository &types_;
-  bpl::list bases_;
 };
 
-class ParamVisitor
+class ParamTranslator
 {
 public:
-  ParamVisitor(SymbolTable &symbols, TypeRepository &types)
+  ParamTranslator(SymbolTable &symbols, TypeRepository &types)
     : asg_module_(bpl::import("Synopsis.ASG")),
       symbols_(symbols),
       types_(types) 
@@ -198,19 +129,28 @@ public:
     qname_ = qname_module.attr("QualifiedCxxName");  
   }
 
-  bpl::list translate_function_parameters(CXCursor parent)
-  {
-    clang_visitChildren(parent, &ParamVisitor::visit_function_parameters, this);
-    return params_;
-  }
-  bpl::list translate_template_parameters(CXCursor parent)
+  bpl::list translate_function_parameters(CursorChildren &children)
+  { return translate(children.parameters());}
+  //. Template template parameters aren't supported yet, and skipped.
+  bpl::list translate_template_parameters(CursorChildren &children)
+  { return translate(children.template_parameters());}
+private:
+
+  bpl::list translate(CursorChildren::Cursors const &cursors)
   {
-    clang_visitChildren(parent, &ParamVisitor::visit_template_parameters, this);
-    return params_;
+    bpl::list params;
+    for (CursorChildren::Cursors::const_iterator i = cursors.begin(); i != cursors.end(); ++i)
+    {
+      bpl::object o = create(*i);
+      // parameters aren't declared. We need them in the symbol table anyhow.
+      symbols_.declare(*i, o);
+      params.append(o);
+    }
+    return params;
   }
-private:
 
   bpl::object qname(std::string const &name) { return qname_(bpl::make_tuple(name));}
+  bpl::object intern(bpl::object type) { return asg_module_.attr("intern_type_id")(type);}
   bpl::object create(CXCursor c)
   {
     CXString n = clang_getCursorSpelling(c);
@@ -229,7 +169,7 @@ private:
       }
       case CXCursor_TemplateTypeParameter:
       {
-	bpl::object type = asg_module_.attr("DependentTypeId")("C++", qname("typename"));
+	bpl::object type = intern(asg_module_.attr("DependentTypeId")("C++", qname("typename")));
 	return asg_module_.attr("Parameter")(bpl::list(), // premod
 					     type,
 					     bpl::list(), // postmod
@@ -249,59 +189,10 @@ private:
 	throw std::runtime_error("unimplemented: " + cursor_info(c));
     }
   }
-  static CXChildVisitResult visit_function_parameters(CXCursor c, CXCursor p, CXClientData d)
-  {
-    ParamVisitor *visitor = static_cast<ParamVisitor*>(d);
-    switch (c.kind)
-    {
-      case CXCursor_TemplateTypeParameter:
-      case CXCursor_TemplateTemplateParameter:
-      case CXCursor_NonTypeTemplateParameter:
-	return CXChildVisit_Continue; // ignore template parameters
-      case CXCursor_ParmDecl:
-      {
-	bpl::object o = visitor->create(c);
-	// parameters aren't declared. We need them in the symbol table anyhow.
-	visitor->symbols_.declare(c, o);
-        visitor->params_.append(o);
-	break;
-      }
-      default:
-	break;
-    }
-    return CXChildVisit_Continue;
-  }
-
-  static CXChildVisitResult visit_template_parameters(CXCursor c, CXCursor p, CXClientData d)
-  {
-    ParamVisitor *visitor = static_cast<ParamVisitor*>(d);
-    switch (c.kind)
-    {
-      case CXCursor_ParmDecl:
-	return CXChildVisit_Continue; // ignore function parameters
-      case CXCursor_TemplateTypeParameter:
-      case CXCursor_NonTypeTemplateParameter:
-      {
-	bpl::object o = visitor->create(c);
-	// parameters aren't declared. We need them in the symbol table anyhow.
-	visitor->symbols_.declare(c, o);
-        visitor->params_.append(o);
-	break;
-      }
-      case CXCursor_TemplateTemplateParameter:
-	break; // TBD
-      default:
-	break;
-    }
-    return CXChildVisit_Continue;
-  }
-
   bpl::object asg_module_;
   bpl::object qname_;
   SymbolTable &symbols_;
   TypeRepository &types_;
-  bpl::list params_;
-
 };
 
 }
@@ -314,7 +205,7 @@ TypeRepository::TypeRepository(bpl::dict types, bool verbose)
   bpl::object qname_module = bpl::import("Synopsis.QualifiedName");
   qname_ = qname_module.attr("QualifiedCxxName");  
 
-#define DECLARE_BUILTIN_TYPE(T) types_[qname(T)] = asg_module_.attr("BuiltinTypeId")("C++", qname(T))
+#define DECLARE_BUILTIN_TYPE(T) types_[qname(T)] = intern(asg_module_.attr("BuiltinTypeId")("C++", qname(T)))
 
   DECLARE_BUILTIN_TYPE("bool");
   DECLARE_BUILTIN_TYPE("char");
@@ -387,7 +278,7 @@ bpl::object TypeRepository::lookup(CXType t) const
       cv_qual(i, postmod);
       postmod.append("&");
       bpl::object inner = lookup(i);
-      return asg_module_.attr("ModifierTypeId")("C++", inner, bpl::list(), postmod);
+      return intern(asg_module_.attr("ModifierTypeId")("C++", inner, bpl::list(), postmod));
     }
     case CXType_Pointer:
     {
@@ -396,7 +287,7 @@ bpl::object TypeRepository::lookup(CXType t) const
       cv_qual(i, postmod);
       postmod.append("*");
       bpl::object inner = lookup(i);
-      return asg_module_.attr("ModifierTypeId")("C++", inner, bpl::list(), postmod);
+      return intern(asg_module_.attr("ModifierTypeId")("C++", inner, bpl::list(), postmod));
     }
     case CXType_ConstantArray:
     {
@@ -404,7 +295,7 @@ bpl::object TypeRepository::lookup(CXType t) const
       bpl::object inner = lookup(i);
       bpl::list sizes;
       sizes.append(clang_getArraySize(t));
-      return asg_module_.attr("ArrayTypeId")("C++", inner, sizes);
+      return intern(asg_module_.attr("ArrayTypeId")("C++", inner, sizes));
     }
     case CXType_Unexposed:
     {
@@ -437,6 +328,7 @@ bpl::object TypeRepository::lookup(CXType t) const
 ASGTranslator::ASGTranslator(std::string const &filename,
 			     std::string const &base_path, bool primary_file_only,
 			     bpl::object asg, bpl::dict files,
+			     std::string const &comment_filter,
 			     bool v, bool d)
   : asg_module_(bpl::import("Synopsis.ASG")),
     sf_module_(bpl::import("Synopsis.SourceFile")),
@@ -445,6 +337,7 @@ ASGTranslator::ASGTranslator(std::string const &filename,
     primary_filename_(filename),
     primary_file_only_(primary_file_only),
     base_path_(base_path),
+    comment_filter_(comment_filter),
     verbose_(v),
     debug_(d)
 {
@@ -469,6 +362,7 @@ ASGTranslator::ASGTranslator(std::string const &filename,
 void ASGTranslator::translate(CXTranslationUnit tu)
 {
   tu_ = tu; // save to make tu accessible elsewhere (tokenization)
+  tokens_.reset(tu);
   CXFile f = clang_getFile(tu, primary_filename_.c_str());
   comment_horizon_ = clang_getLocationForOffset(tu, f, 0);
   // prev_cursor_.push(clang_getNullCursor())
@@ -525,9 +419,16 @@ void ASGTranslator::declare(CXCursor c, bpl::object d)
     declarations_.append(d);
   bpl::extract<bpl::list>(file_.attr("declarations"))().append(d);
   symbols_.declare(c, d);
+  Profiler::count("objects");
 }
 
 bpl::object ASGTranslator::create(CXCursor c)
+{
+  CursorChildren children(c);
+  return create(c, children);
+}
+
+bpl::object ASGTranslator::create(CXCursor c, CursorChildren &children)
 {
   if (verbose_)
     std::cout << "create " << cursor_info(c) << std::endl;
@@ -586,7 +487,7 @@ bpl::object ASGTranslator::create(CXCursor c)
     }
     case CXCursor_MacroDefinition:
     {
-      MacroDefinition definition(tu_, c);
+      MacroDefinition definition(tokens_, c);
       return asg_module_.attr("Macro")(source_file, line,
 				       "macro", // type
 				       qname(name),
@@ -611,8 +512,8 @@ bpl::object ASGTranslator::create(CXCursor c)
 	name = clang_getCString(sn);
 	clang_disposeString(sn);
       }
-      ParamVisitor param_visitor(symbols_, types_);
-      bpl::list params = param_visitor.translate_template_parameters(c);
+      ParamTranslator param_translator(symbols_, types_);
+      bpl::list params = param_translator.translate_template_parameters(children);
       CXCursorKind k = clang_getTemplateCursorKind(c);
       char const *kind = "class";
       if (k == CXCursor_StructDecl) kind == "struct";
@@ -647,8 +548,8 @@ bpl::object ASGTranslator::create(CXCursor c)
     }
     case CXCursor_EnumConstantDecl:
     {
-      Stringifier stringifier(tu_);
-      bpl::object value(stringifier.stringify(c));
+      Stringifier stringifier(tokens_);
+      bpl::object value(stringifier.stringify(children));
       return asg_module_.attr("Enumerator")(source_file, line, qname(name), value);
     }
     case CXCursor_VarDecl:
@@ -665,8 +566,8 @@ bpl::object ASGTranslator::create(CXCursor c)
       if (stype == "class" || stype == "struct" || stype == "union") vtype = "data member";
       if (is_const)
       {
-	Stringifier stringifier(tu_);
-	bpl::object value(stringifier.stringify(c));
+	Stringifier stringifier(tokens_);
+	bpl::object value(stringifier.stringify(children));
 	return asg_module_.attr("Const")(source_file, line, vtype, qname(name), type, value);
       }
       else
@@ -701,7 +602,7 @@ bpl::object ASGTranslator::create(CXCursor c)
       std::string full_name = clang_getCString(dn);
       clang_disposeString(dn);
       bpl::object return_type = types_.lookup(clang_getCursorResultType(c));
-      visit_children(c);
+      visit_children(c, children);
       bpl::object f;
       if (c.kind == CXCursor_FunctionTemplate)
       {
@@ -712,8 +613,8 @@ bpl::object ASGTranslator::create(CXCursor c)
 						 bpl::list(), // postmod
 						 qname(full_name), // fname (mangled)
 						 name); // fname
-	ParamVisitor param_visitor(symbols_, types_);
-	bpl::list params = param_visitor.translate_template_parameters(c);
+	ParamTranslator param_translator(symbols_, types_);
+	bpl::list params = param_translator.translate_template_parameters(children);
 	bpl::object t_id = asg_module_.attr("TemplateId")("C++", qname(name), f, params);
 	f.attr("template") = t_id;
       }
@@ -746,14 +647,13 @@ bpl::object ASGTranslator::create(CXCursor c)
 					  qname(full_name), // fname (mangled)
 					  name); // fname
       }
-      ParamVisitor param_visitor(symbols_, types_);
-      f.attr("parameters") = param_visitor.translate_function_parameters(c);
+      ParamTranslator param_translator(symbols_, types_);
+      f.attr("parameters") = param_translator.translate_function_parameters(children);
       return f;
     }
     case CXCursor_UsingDirective:
     {
-      UsingDirectiveDereferencer udd;
-      CXCursor r = udd.reference(c);
+      CXCursor r = clang_getCursorReferenced(children.namespace_ref());
       bpl::object aliased = symbols_.lookup(r);
       return asg_module_.attr("UsingDirective")(source_file, line, "using", bpl::object(aliased.attr("name")));
     }
@@ -811,7 +711,8 @@ CXChildVisitResult ASGTranslator::visit_declaration(CXCursor c, CXCursor p)
   bpl::list comments = get_comments(c);
   bool consume_comments = true;
   CXType type = clang_getCursorType(c);
-  bpl::list bases;
+  // Shared by everything below that needs the cursor's children.
+  CursorChildren children(c);
   switch (c.kind)
   {
     case CXCursor_StructDecl:
@@ -821,7 +722,7 @@ CXChildVisitResult ASGTranslator::visit_declaration(CXCursor c, CXCursor p)
     case CXCursor_ClassTemplatePartialSpecialization:
     case CXCursor_Namespace:
     {
-      declaration = create(c);
+      declaration = create(c, children);
       // If this is a namespace, only add it the first time
       if (c.kind == CXCursor_Namespace)
       {
@@ -843,8 +744,8 @@ CXChildVisitResult ASGTranslator::visit_declaration(CXCursor c, CXCursor p)
       else
       {
 	declare(c, declaration);
-	BaseSpecVisitor base_visitor(types_);
-	declaration.attr("parents") = base_visitor.find_bases(c);
+	BaseSpecTranslator base_translator(types_);
+	declaration.attr("parents") = base_translator.translate(children);
       }
       if (c.kind == CXCursor_ClassTemplatePartialSpecialization)
       {
@@ -863,12 +764,12 @@ CXChildVisitResult ASGTranslator::visit_declaration(CXCursor c, CXCursor p)
       if (type.kind != CXType_Invalid) // e.g. for namespaces
 	types_.declare(type, declaration, true);
       scope_.push(declaration);
-      visit_children(c);
+      visit_children(c, children);
       scope_.pop();
       break;
     }
     case CXCursor_EnumConstantDecl:
-      declaration = create(c);
+      declaration = create(c, children);
       // enumerators aren't declared. We need them in the symbol table anyhow.
       symbols_.declare(c, declaration);
       enumerators_.append(declaration);
@@ -878,13 +779,13 @@ CXChildVisitResult ASGTranslator::visit_declaration(CXCursor c, CXCursor p)
     case CXCursor_TypedefDecl:
       if (type.kind != CXType_Invalid) // e.g. builtin typendefs
       {
-	declaration = create(c);
+	declaration = create(c, children);
 	declare(c, declaration);
 	types_.declare(type, declaration, true);
       }
       break;
     case CXCursor_EnumDecl:
-      declaration = create(c);
+      declaration = create(c, children);
       declare(c, declaration);
       types_.declare(type, declaration, true);
       break;
@@ -895,7 +796,7 @@ CXChildVisitResult ASGTranslator::visit_declaration(CXCursor c, CXCursor p)
     case CXCursor_CXXMethod:
     case CXCursor_ConversionFunction:
     case CXCursor_UsingDeclaration:
-      declaration = create(c);
+      declaration = create(c, children);
       declare(c, declaration);
       break;
     case CXCursor_UsingDirective:
@@ -935,6 +836,15 @@ void ASGTranslator::visit_children(CXCursor c)
   comment_horizon_ = comment_horizon_backup;
 }
 
+void ASGTranslator::visit_children(CXCursor c, CursorChildren &children)
+{
+  CXSourceLocation comment_horizon_backup = comment_horizon_;
+  CursorChildren::Cursors const &all = children.all();
+  for (CursorChildren::Cursors::const_iterator i = all.begin(); i != all.end(); ++i)
+    visit(*i, c, this);
+  comment_horizon_ = comment_horizon_backup;
+}
+
 bpl::list ASGTranslator::get_comments(CXCursor c)
 {
   // Terminology:
@@ -945,7 +855,13 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
   // In addition, if the given cursor is separated from preceding comments by an
   // empty line, an empty item is pushed into the list, to allow comment-processors
   // to take this into account during filtering.
-  bpl::list comments;
+  //
+  // Comments the comment filter rejects are replaced by None, without ever
+  // being converted to Python strings.
+  //
+  // As comments are found walking backwards, they are collected in reverse order.
+  std::vector<std::string> comments;
+  bool separated = false;
   bool next_is_cxx_comment = false;
   unsigned next_token_start_line;
   clang_getSpellingLocation(clang_getRangeStart(clang_getCursorExtent(c)),
@@ -959,6 +875,7 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
   CXToken *tokens;
   unsigned num_tokens;
   clang_tokenize(tu_, range, &tokens, &num_tokens);
+  Profiler::count("tokens", num_tokens);
   // FIXME: Due to a bug in clang_tokenize, the last token returned is actually outside
   //        the range
   if (num_tokens) --num_tokens;
@@ -978,7 +895,7 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
     //        to be empty (and thus can't be seen by the extent-computing machinery.
     //
     //        As a simple heuristic (and until we find a better solution), ignore such tokens.
-    if (kind == CXToken_Identifier && bpl::len(comments) == 0)
+    if (kind == CXToken_Identifier && comments.empty())
     {
       // look it up to see whether it is actually part of a macro instantiation (and defines to nothing).
       //...
@@ -995,21 +912,19 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
 			      0, &prev_token_end_line, 0, 0);
     // If the comment directly preceding the cursor is separated from it by
     // an empty line, insert an empty string into the comments.
-    if (bpl::len(comments) == 0 &&
+    if (comments.empty() &&
 	prev_token_end_line + 1 != next_token_start_line)
-      comments.append("");
+      separated = true;
 
     // If two consecutive comments are both C++-style and are only separated by
     // a single newline, concatenate them.
     if (prev_token_end_line + 1 == next_token_start_line &&
 	is_cxx_comment && next_is_cxx_comment)
     {
-      std::string comment = bpl::extract<std::string>(comments[0]);
-      comment.insert(0, "\n");
-      comment.insert(0, text);
-      comments[0] = comment;
+      comments.back().insert(0, 1, '\n');
+      comments.back().insert(0, text);
     }
-    else comments.insert(0, text);
+    else comments.push_back(text);
 
     clang_disposeString(s);
 
@@ -1018,7 +933,16 @@ bpl::list ASGTranslator::get_comments(CXCursor c)
 			      0, &next_token_start_line, 0, 0);
   }
   clang_disposeTokens(tu_, tokens, num_tokens);
-  return comments;
+  bpl::list result;
+  for (std::vector<std::string>::reverse_iterator i = comments.rbegin();
+       i != comments.rend();
+       ++i)
+  {
+    if (comment_filter_.accept(*i)) result.append(*i);
+    else result.append(bpl::object());
+  }
+  if (separated) result.append("");
+  return result;
 }
 
 CXChildVisitResult ASGTranslator::visit(CXCursor c, CXCursor p, CXClientData d)
@@ -1026,6 +950,7 @@ CXChildVisitResult ASGTranslator::visit(CXCursor c, CXCursor p, CXClientData d)
   ASGTranslator *translator = static_cast<ASGTranslator*>(d);
   if (translator->verbose_)
     std::cout << "visit " << cursor_info(c) << std::endl;
+  Profiler::count("cursors");
 
   try
   {
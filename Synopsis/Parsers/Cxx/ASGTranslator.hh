@@ -10,8 +10,11 @@
 
 #include <boost/python.hpp>
 #include <clang-c/Index.h>
+#include <Support/CommentFilter.hh>
+#include <Support/TokenCache.hh>
 #include <stack>
 #include <map>
+#include <vector>
 
 namespace bpl = boost::python;
 
@@ -51,6 +54,8 @@ public:
 
 private:
   bpl::object qname(std::string const &name) const { return qname_(bpl::make_tuple(name));}
+  //. Return the shared type-id equal to the given one (see ASG.intern_type_id).
+  bpl::object intern(bpl::object type) const { return asg_module_.attr("intern_type_id")(type);}
 
   bpl::object asg_module_;
   bpl::object qname_;
@@ -59,12 +64,78 @@ private:
   bool verbose_;
 };
 
+//. The children of a cursor, sorted by the role they play in its
+//. declaration. They are all collected in a single traversal, the first
+//. time any of them are asked for, so the translation of a declaration
+//. visits the children of its cursor only once.
+class CursorChildren
+{
+public:
+  typedef std::vector<CXCursor> Cursors;
+
+  CursorChildren(CXCursor parent) : parent_(parent), collected_(false) {}
+
+  //. All children, in order.
+  Cursors const &all() { collect(); return all_;}
+  //. The base specifiers of a class.
+  Cursors const &bases() { collect(); return bases_;}
+  //. The parameters of a function.
+  Cursors const &parameters() { collect(); return parameters_;}
+  //. The (type and non-type) parameters of a template.
+  Cursors const &template_parameters() { collect(); return template_parameters_;}
+  //. The last namespace reference, which for a using directive refers
+  //. to the namespace itself, even if its name is qualified.
+  CXCursor namespace_ref() { collect(); return namespace_ref_;}
+
+private:
+  void collect()
+  {
+    if (collected_) return;
+    collected_ = true;
+    namespace_ref_ = clang_getNullCursor();
+    clang_visitChildren(parent_, &CursorChildren::visit, this);
+  }
+  static CXChildVisitResult visit(CXCursor c, CXCursor, CXClientData d)
+  {
+    CursorChildren *children = static_cast<CursorChildren *>(d);
+    children->all_.push_back(c);
+    switch (c.kind)
+    {
+      case CXCursor_CXXBaseSpecifier:
+	children->bases_.push_back(c);
+	break;
+      case CXCursor_ParmDecl:
+	children->parameters_.push_back(c);
+	break;
+      case CXCursor_TemplateTypeParameter:
+      case CXCursor_NonTypeTemplateParameter:
+	children->template_parameters_.push_back(c);
+	break;
+      case CXCursor_NamespaceRef:
+	children->namespace_ref_ = c;
+	break;
+      default:
+	break;
+    }
+    return CXChildVisit_Continue;
+  }
+
+  CXCursor parent_;
+  bool     collected_;
+  Cursors  all_;
+  Cursors  bases_;
+  Cursors  parameters_;
+  Cursors  template_parameters_;
+  CXCursor namespace_ref_;
+};
+
 class ASGTranslator
 {
 public:
   ASGTranslator(std::string const &filename,
 		std::string const &base_path, bool primary_file_only,
-		bpl::object asg, bpl::dict files, bool v, bool d);
+		bpl::object asg, bpl::dict files,
+		std::string const &comment_filter, bool v, bool d);
 
   void translate(CXTranslationUnit);
 
@@ -81,15 +152,19 @@ private:
   CXChildVisitResult visit_declaration(CXCursor c, CXCursor p);
 
   void visit_children(CXCursor c);
+  //. Visit children collected earlier, as visit_children(c) would.
+  void visit_children(CXCursor c, CursorChildren &children);
 
   bpl::object get_source_file(std::string const &);
   bpl::object create(CXCursor c);
+  bpl::object create(CXCursor c, CursorChildren &children);
 
   bpl::list get_comments(CXCursor);
 
   static CXChildVisitResult visit(CXCursor c, CXCursor p, CXClientData d);
 
   CXTranslationUnit tu_;
+  Synopsis::TokenCache tokens_;
   bpl::object       qname_;
   bpl::object       asg_module_;
   bpl::object       sf_module_;
@@ -109,6 +184,7 @@ private:
   std::string       primary_filename_;
   bool              primary_file_only_;
   std::string       base_path_;
+  Synopsis::CommentFilter comment_filter_;
   bool              verbose_;
   bool              debug_;
 };
@@ -7,7 +7,7 @@
 
 #include "ASGTranslator.hh"
 #include "SXRGenerator.hh"
-#include <Support/Timer.hh>
+#include <Support/PythonProfiler.hh>
 #include <Support/path.hh>
 #include <boost/filesystem/convenience.hpp>
 #include <clang-c/Index.h>
@@ -55,7 +55,9 @@ void merge_files(bpl::dict ir_files, bpl::dict new_files)
 
 bpl::object parse(bpl::object ir,
                   char const *cpp_file, char const *input_file, char const *base_path,
-                  bool primary_file_only, char const *sxr_prefix,
+                  bool primary_file_only,
+                  char const *sxr_prefix, char const *sxr_format,
+                  char const *comment_filter,
 		  bpl::list cpp_flags,
                   bool verbose, bool debug, bool profile)
 {
@@ -71,18 +73,21 @@ bpl::object parse(bpl::object ir,
   for (size_t i = 0; i != bpl::len(cpp_flags); ++i)
     args[i + 2] = bpl::extract<char const *>(cpp_flags[i]);
 
-  Timer timer;
+  ProfileSubmitter submitter(profile);
   // first arg: exclude declarations from PCH
   // second arg: display diagnostics
   CXIndex idx = clang_createIndex(0, 1);
   CXTranslationUnit_Flags flags = CXTranslationUnit_DetailedPreprocessingRecord;
-  CXTranslationUnit tu = 
-    clang_parseTranslationUnit(idx, input_file,
-			       args,
-			       bpl::len(cpp_flags) + 2,
-			       0,  // unsaved_files
-			       0,  // num_unsaved_files
-			       flags);
+  CXTranslationUnit tu;
+  {
+    Profiler::Zone zone("C++ parser");
+    tu = clang_parseTranslationUnit(idx, input_file,
+                                    args,
+                                    bpl::len(cpp_flags) + 2,
+                                    0,  // unsaved_files
+                                    0,  // num_unsaved_files
+                                    flags);
+  }
   delete [] args;
   if (!tu) 
   {
@@ -90,9 +95,6 @@ bpl::object parse(bpl::object ir,
     return ir;
   }
 
-  if (profile)
-    std::cout << "C++ parser took " << timer.elapsed() 
-              << " seconds" << std::endl;
   unsigned diagnostics = clang_getNumDiagnostics(tu);
   if (diagnostics)
   {
@@ -108,17 +110,16 @@ bpl::object parse(bpl::object ir,
   }
   bpl::object asg = ir.attr("asg");
   bpl::dict files;
-  timer.reset();
-  ASGTranslator translator(input_file, base_path, primary_file_only, asg, files, verbose, debug);
-  translator.translate(tu);
-
-  if (profile)
-    std::cout << "ASG translation took " << timer.elapsed() 
-	      << " seconds" << std::endl;
+  ASGTranslator translator(input_file, base_path, primary_file_only, asg, files,
+                           comment_filter ? comment_filter : "", verbose, debug);
+  {
+    Profiler::Zone zone("ASG translation");
+    translator.translate(tu);
+  }
   if (sxr_prefix)
   {
-    timer.reset();
-    SXRGenerator generator(translator, verbose, debug);
+    Profiler::Zone zone("SXR generation");
+    SXRGenerator generator(translator, sxr_format ? sxr_format : "", verbose, debug);
     for (size_t i = 0; i != bpl::len(files); ++i)
     {
       bpl::object sf = files.attr("values")()[i];
@@ -129,9 +130,6 @@ bpl::object parse(bpl::object ir,
       create_directories(fs::path(sxr).branch_path());
       generator.generate(tu, sxr, abs_name, name);
     }
-    if (profile)
-      std::cout << "SXR generation took " << timer.elapsed() 
-  		<< " seconds" << std::endl;
   }
   merge_files(bpl::extract<bpl::dict>(ir.attr("files")), files);
 
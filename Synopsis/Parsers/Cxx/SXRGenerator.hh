@@ -5,9 +5,10 @@
 // see the file COPYING for details.
 //
 #include "ASGTranslator.hh"
+#include <Support/SXR.hh>
 #include <clang-c/Index.h>
 #include <iostream>
-#include <fstream>
+#include <boost/scoped_ptr.hpp>
 
 #ifndef SXRGenerator_hh_
 #define SXRGenerator_hh_
@@ -15,7 +16,7 @@
 class SXRGenerator
 {
 public:
-  SXRGenerator(ASGTranslator const &, bool, bool);
+  SXRGenerator(ASGTranslator const &, std::string const &format, bool, bool);
 
   void generate(CXTranslationUnit,
 		std::string const &sxr, std::string const &abs_filename, std::string const &filename);
@@ -25,14 +26,12 @@ private:
   std::string xref(CXCursor);
   std::string from(CXCursor);
   void write_comment(std::string const &, unsigned &line);
-  void write_xref(CXToken const &);
-  void write(char const *, size_t = 0);
-  void write_esc(std::string const &);
-  void write_esc(char const *);
+  void write_xref(CXSourceLocation, char const *, size_t);
 
   CXTranslationUnit tu_;  
   ASGTranslator const &translator_;
-  std::filebuf obuf_;
+  std::string format_;
+  boost::scoped_ptr<Synopsis::SXR::Writer> writer_;
   bool verbose_;
   bool debug_;
 };
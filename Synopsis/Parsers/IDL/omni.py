@@ -5,7 +5,7 @@
 # see the file COPYING for details.
 #
 
-from Synopsis import IR, ASG
+from Synopsis import IR, ASG, Profiler
 from Synopsis.QualifiedName import QualifiedCxxName as QName
 from Synopsis.SourceFile import *
 import idlast, idltype, idlvisitor, idlutil
@@ -61,7 +61,7 @@ class TypeTranslator(idlvisitor.TypeVisitor):
 
    def visitBaseType(self, idltype):
 
-      type = ASG.BuiltinTypeId('IDL', self.__basetypes[idltype.kind()])
+      type = ASG.intern_type_id(ASG.BuiltinTypeId('IDL', self.__basetypes[idltype.kind()]))
       self.types[type.name] = type
       self.__result = type.name
 
@@ -73,7 +73,7 @@ class TypeTranslator(idlvisitor.TypeVisitor):
       else:
          qname = QName(('string<%s>'%idltype.bound(),))
       if qname not in self.types:
-         self.types[qname] = ASG.BuiltinTypeId('IDL', qname)
+         self.types[qname] = ASG.intern_type_id(ASG.BuiltinTypeId('IDL', qname))
       self.__result = qname
 
    def visitWStringType(self, idltype):
@@ -84,14 +84,14 @@ class TypeTranslator(idlvisitor.TypeVisitor):
       else:
          qname = QName(('wstring<%s>'%idltype.bound(),))
       if qname not in self.types:
-         self.types[qname] = ASG.BuiltinTypeId('IDL', qname)
+         self.types[qname] = ASG.intern_type_id(ASG.BuiltinTypeId('IDL', qname))
       self.__result = qname
 
    def visitSequenceType(self, idltype):
 
       qname = QName(('sequence',))
       if not self.types.has_key(qname):
-         self.types[qname] = ASG.BuiltinTypeId("IDL", qname)
+         self.types[qname] = ASG.intern_type_id(ASG.BuiltinTypeId("IDL", qname))
       idltype.seqType().accept(self)
       ptype = self.types[self.__result]
       type = ASG.ParametrizedTypeId("IDL", self.types[qname], [ptype])
@@ -221,7 +221,7 @@ class ASGTranslator(idlvisitor.AstVisitor):
          # a single typedef declaration can have a different type. *sigh*
          dtype = type
          if d.sizes():
-            array = ASG.ArrayTypeId('IDL', self.getType(type), [str(s) for s in d.sizes()])
+            array = ASG.intern_type_id(ASG.ArrayTypeId('IDL', self.getType(type), [str(s) for s in d.sizes()]))
             dtype = map(None, type[:-1])
             dtype.append(type[-1] + string.join(map(lambda s:"["+ str(s) +"]", d.sizes()),''))
             self.addType(QName(dtype), array)
@@ -249,7 +249,7 @@ class ASGTranslator(idlvisitor.AstVisitor):
          # a single typedef declaration can have a different type. *sigh*
          dtype = type
          if d.sizes():
-            array = ASG.ArrayTypeId('IDL', self.getType(type), [str(s) for s in node.sizes()])
+            array = ASG.intern_type_id(ASG.ArrayTypeId('IDL', self.getType(type), [str(s) for s in node.sizes()]))
             dtype = type[:-1]
             dtype.append(type[-1] + string.join(map(lambda s:"["+s+"]", d.sizes()),''))
             self.addType(dtype, array)
@@ -315,7 +315,7 @@ class ASGTranslator(idlvisitor.AstVisitor):
       type = self.types.internalize(node.caseType())
       declarator = node.declarator()
       if declarator.sizes():
-         array = ASG.ArrayTypeId('IDL', self.getType(type), [str(s) for s in declarator.sizes()])
+         array = ASG.intern_type_id(ASG.ArrayTypeId('IDL', self.getType(type), [str(s) for s in declarator.sizes()]))
          type = type[:-1]
          type.append(type[-1] + string.join(map(lambda s:"["+s+"]",node.sizes()),''))
          self.addType(type, array)
@@ -438,7 +438,11 @@ def parse(ir, cppfile, src, primary_file_only,
 
    _omniidl.keepComments(1)
    _omniidl.noForwardWarning()
-   tree = _omniidl.compile(open(cppfile, 'r+'))
+   zone = Profiler.zone('IDL parser')
+   try:
+      tree = _omniidl.compile(open(cppfile, 'r+'))
+   finally:
+      zone.end()
    if tree == None:
       sys.stderr.write("omni: Error parsing %s\n"%cppfile)
       sys.exit(1)
@@ -449,7 +453,12 @@ def parse(ir, cppfile, src, primary_file_only,
    new_ir.files[sourcefile.name] = sourcefile
    type_trans = TypeTranslator(new_ir.asg.types)
    ast_trans = ASGTranslator(new_ir.asg.declarations, type_trans, primary_file_only)
-   tree.accept(ast_trans)
+   zone = Profiler.zone('ASG translation')
+   try:
+      tree.accept(ast_trans)
+      Profiler.count('objects', len(new_ir.asg.types))
+   finally:
+      zone.end()
    sourcefile.declarations[:] = new_ir.asg.declarations
    ir.merge(new_ir)
    _omniidl.clear()
@@ -173,7 +173,7 @@ class ASGTranslator(ASTVisitor):
         self.file = None
         self.types = types
         self.attributes = []
-        self.any_type = ASG.BuiltinTypeId('Python',QName('',))
+        self.any_type = ASG.intern_type_id(ASG.BuiltinTypeId('Python',QName('',)))
         self.docformat = docformat
         self.documentable = None
         self.name = QName()
@@ -10,6 +10,7 @@ import token
 import tokenize
 import symbol
 import keyword
+from Synopsis import SXRFormat
 
 HAVE_ENCODING_DECL = hasattr(symbol, "encoding_decl") # python 2.3
 HAVE_IMPORT_NAME = hasattr(symbol, "import_name") # python 2.4
@@ -34,20 +35,6 @@ class LexerDebugger:
         print 'next is "%s" (%s)'%(n[1], n[0])
         return n
 
-header="""<sxr filename="%(filename)s">
-<line>"""
-
-trailer="""</line>
-</sxr>
-"""
-
-def escape(text):
-
-    for p in [('&', '&amp;'), ('"', '&quot;'), ('<', '&lt;'), ('>', '&gt;'),]:
-        text = text.replace(*p)
-    return text
-
-
 class SXRGenerator:
     """"""
 
@@ -84,7 +71,7 @@ class SXRGenerator:
         self.parameters = []
         self.scopes = []
 
-    def process_file(self, scope, sourcefile, sxr):
+    def process_file(self, scope, sourcefile, sxr, format = 'xml'):
 
         self.scopes = list(scope)
         input = open(sourcefile.abs_name, 'r+')
@@ -94,15 +81,12 @@ class SXRGenerator:
         input.seek(0)
         self.lexer = tokenize.generate_tokens(input.readline)
         #self.lexer = LexerDebugger(tokenize.generate_tokens(input.readline))
-        self.sxr = open(sxr, 'w+')
-        lineno_template = '%%%ds' % self.lines
-        lineno = lineno_template % self.lineno
-        self.sxr.write(header % {'filename': sourcefile.name})
+        self.sxr = SXRFormat.make_writer(format, sxr, sourcefile.name)
         try:
             self.handle(ptree)
         except StopIteration:
             raise
-        self.sxr.write(trailer)
+        self.sxr.close()
         self.scopes.pop()
 
     def handle(self, ptree):
@@ -155,12 +139,8 @@ class SXRGenerator:
             raise 'Internal error in line %d: expected name "%s", got "%s" (%d)'%(name, self.lineno, item, t[1], t[0])
 
         if self.col != scol:
-            self.sxr.write(' ' * (scol - self.col))
-        attrs = []
-        if from_: attrs.append('from="%s"'%from_)
-        if type: attrs.append('type="%s"'%type)
-        a = '<a href="%s" %s>%s</a>'%('.'.join(xref), ' '.join(attrs), value)
-        self.sxr.write(a)
+            self.sxr.space(scol - self.col)
+        self.sxr.anchor('.'.join(xref), from_, type or '', value)
         self.col = ecol
   
 
@@ -359,24 +339,25 @@ class SXRGenerator:
             self.print_newline()
         else:
             if self.col != scol:
-                self.sxr.write(' ' * (scol - self.col))
+                self.sxr.space(scol - self.col)
             if keyword.iskeyword(value):
-                format = '<span class="py-keyword">%s</span>'
+                class_ = 'py-keyword'
             elif kind == token.STRING:
-                format = '<span class="py-string">%s</span>'
+                class_ = 'py-string'
                 chunks = value.split('\n')
                 for c in chunks[:-1]:
-                    self.sxr.write(format % escape(c))
+                    self.sxr.span(class_, c)
                     self.print_newline()
                 value = chunks[-1]
                     
             elif kind == tokenize.COMMENT:
-                format = '<span class="py-comment">%s</span>'
+                class_ = 'py-comment'
                 if value[-1] == '\n': value = value[:-1]
             else:
-                format = '%s'
+                class_ = None
 
-            self.sxr.write(format % escape(value))
+            if class_: self.sxr.span(class_, value)
+            else: self.sxr.text(value)
             self.col = ecol
 
 
@@ -384,7 +365,6 @@ class SXRGenerator:
 
         self.col = 0
         self.lineno += 1
-        self.sxr.write('</line>\n')
-        self.sxr.write('<line>')
+        self.sxr.newline()
 
 
@@ -54,6 +54,7 @@ class Parser(Processor):
     primary_file_only = Parameter(True, 'should only primary file be processed')
     base_path = Parameter('', 'Path prefix to strip off of input file names.')
     sxr_prefix = Parameter(None, 'Path prefix (directory) to contain sxr info.')
+    sxr_format = Parameter('xml', "Format of sxr files ('xml', 'binary', or 'compressed').")
     default_docformat = Parameter('', 'default documentation format')
     
     def process(self, ir, **kwds):
@@ -64,7 +65,7 @@ class Parser(Processor):
         self.scopes = []
       
         # Create return type for Python functions:
-        self.return_type = ASG.BuiltinTypeId('Python',('',))
+        self.return_type = ASG.intern_type_id(ASG.BuiltinTypeId('Python',('',)))
 
         # Validate base_path.
         if self.base_path:
@@ -141,4 +142,4 @@ class Parser(Processor):
 
             sxr_generator = SXRGenerator()
             module = sourcefile.declarations[0]
-            sxr_generator.process_file(module.name, sourcefile, sxr)
+            sxr_generator.process_file(module.name, sourcefile, sxr, self.sxr_format)
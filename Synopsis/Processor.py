@@ -7,6 +7,78 @@
 
 from Error import *
 import IR
+import ASG
+import Profiler
+import os, types
+
+def _merge_files(args):
+   """Load and merge the IR files in 'args[0]', saving the result to 'args[1]'.
+   This runs inside a worker process of 'Processor.merge_input'."""
+
+   files, output = args
+   ir = IR.load(files[0])
+   for file in files[1:]:
+      ir.merge(IR.load(file))
+   ir.save(output)
+   return output
+
+def _profiled(process, name):
+   """Wrap a 'process' method, to profile it as the zone 'name'. The
+   outermost processor with a 'profile' (or 'profile_trace') parameter
+   starts profiling, and reports the result once it is done."""
+
+   def profiled(self, *args, **kwds):
+      if Profiler.enabled():
+         zone = Profiler.zone(name)
+         try:
+            return process(self, *args, **kwds)
+         finally:
+            zone.end()
+      profile = kwds.get('profile', getattr(self, 'profile', False))
+      trace = kwds.get('profile_trace', getattr(self, 'profile_trace', ''))
+      if not profile and not trace:
+         return process(self, *args, **kwds)
+      Profiler.start()
+      zone = Profiler.zone(name)
+      try:
+         return process(self, *args, **kwds)
+      finally:
+         zone.end()
+         events = Profiler.stop()
+         if profile: print Profiler.summary(events)
+         if trace: Profiler.write_trace(trace, events)
+
+   profiled.__name__ = process.__name__
+   profiled.__doc__ = process.__doc__
+   return profiled
+
+_transient = ('verbose', 'debug', 'profile', 'profile_trace',
+              'input', 'output', 'jobs', 'manifest')
+"""The parameters that don't affect the result of processing."""
+
+def _describe(value, seen = ()):
+   """Return a string describing the parameter value 'value', for
+   'Processor.configuration'. Parametrized values, such as sub-processors,
+   are described by their parameters, other objects by their type."""
+
+   if isinstance(value, Parametrized):
+      if id(value) in seen: return '...'
+      seen += (id(value),)
+      names = [n for n in sorted(value._parameters) if n not in _transient]
+      return '%s.%s(%s)'%(type(value).__module__, type(value).__name__,
+                          ', '.join(['%s=%s'%(n, _describe(getattr(value, n), seen))
+                                     for n in names]))
+   elif isinstance(value, (list, tuple)):
+      return '[%s]'%', '.join([_describe(v, seen) for v in value])
+   elif isinstance(value, dict):
+      return '{%s}'%', '.join(sorted(['%r: %s'%(k, _describe(v, seen))
+                                      for k, v in value.iteritems()]))
+   elif isinstance(value, (basestring, int, long, float, type(None))):
+      return repr(value)
+   elif isinstance(value, (type, types.ClassType, types.FunctionType)):
+      return '%s.%s'%(value.__module__, value.__name__)
+   else:
+      return '%s.%s'%(value.__class__.__module__, value.__class__.__name__)
 
 class Parameter(object):
    """A Parameter is a documented value, kept inside a Processor."""
@@ -19,7 +91,8 @@ class Type(type):
    def __init__(cls, name, bases, dict):
       """Generate a '_parameters' dictionary holding all the 'Parameter' objects.
       Then replace 'Parameter' objects by their values for convenient use inside
-      the code."""
+      the code. The 'process' method of processors is profiled
+      (see Synopsis.Profiler)."""
       parameters = {}
       for i in dict:
          if isinstance(dict[i], Parameter):
@@ -27,6 +100,9 @@ class Type(type):
       for i in parameters:
          setattr(cls, i, dict[i].value)
       setattr(cls, '_parameters', parameters)
+      if hasattr(cls, 'profile') and callable(dict.get('process')):
+         setattr(cls, 'process',
+                 _profiled(dict['process'], '%s.%s'%(cls.__module__, name)))
 
 class Parametrized(object):
    """Parametrized implements handling of Parameter attributes."""
@@ -88,21 +164,99 @@ class Processor(Parametrized):
    verbose = Parameter(False, "operate verbosely")
    debug = Parameter(False, "generate debug traces")
    profile = Parameter(False, "output profile data")
+   profile_trace = Parameter('', "file to write profile data to, in the Chrome trace-event format")
    input = Parameter([], "input files to process")
    output = Parameter('', "output file to save the ir to")
+   jobs = Parameter(1, "number of worker processes (used to merge input files, for example)")
+   manifest = Parameter('', "file recording dependencies, for incremental rebuilds")
+
+   def get_manifest(self):
+      """Return the Manifest named by the 'manifest' parameter, if any."""
+
+      if not self.manifest: return None
+      import Manifest
+      return Manifest.open_manifest(self.manifest)
+
+   def configuration(self):
+      """Return a digest of the parameters affecting this processor's
+      result, including those of sub-processors and other parametrized
+      values (such as views or markup formatters). Parameters such as
+      'verbose', 'input' or 'output' are left out."""
+
+      import Manifest
+      return Manifest.md5(_describe(self)).hexdigest()
+
+   def output_is_current(self, ir):
+      """Return True if 'output' was generated by an earlier run from
+      the same (unchanged) 'input', and with the same configuration, so
+      processing can be skipped. The manifest doesn't know what 'ir'
+      holds, so this is only the case if it is empty."""
+
+      manifest = self.get_manifest()
+      if not manifest or not self.output: return False
+      # Processing may modify parameter values, so record the
+      # configuration the output is generated with.
+      self._configuration = self.configuration()
+      return bool(self.input and
+                  not (ir.files or ir.asg.declarations or ir.asg.types or ir.sxr) and
+                  manifest.is_current(self.output, self._configuration))
+
+   def record_output(self, is_ir = False):
+      """Record the 'input' the 'output' was generated from in the manifest,
+      as well as the configuration it was generated with."""
+
+      manifest = self.get_manifest()
+      if manifest and self.output:
+         configuration = getattr(self, '_configuration', None) or self.configuration()
+         manifest.record(self.output, self.input, configuration, is_ir)
+         manifest.save()
 
    def merge_input(self, ir):
       """Join the given IR with a set of IRs to be read from 'input' parameter"""
       input = getattr(self, 'input', [])
+      jobs = getattr(self, 'jobs', 1)
+      if jobs > 1 and len(input) > 2:
+         return self.merge_input_parallel(ir, input, jobs)
       for file in input:
          ir.merge(IR.load(file))
       return ir
 
+   def merge_input_parallel(self, ir, input, jobs):
+      """Merge the 'input' IR files as a balanced reduction tree, using a pool
+      of 'jobs' worker processes. Inputs are paired up by position at each
+      level, so the result does not depend on the order in which workers
+      complete. Intermediate IRs are passed between levels as temporary files."""
+
+      import multiprocessing, tempfile, shutil
+
+      tmpdir = tempfile.mkdtemp(prefix='synopsis-merge-')
+      pool = multiprocessing.Pool(jobs)
+      try:
+         files, level = list(input), 0
+         while len(files) > 1:
+            tasks = [(files[i:i + 2], os.path.join(tmpdir, '%d-%d.syn'%(level, i)))
+                     for i in range(0, len(files), 2)]
+            if self.verbose:
+               print 'merging %d IR files into %d'%(len(files), len(tasks))
+            merged = pool.map(_merge_files, tasks, 1)
+            # intermediate results of the previous level are no longer needed
+            if level:
+               for f in files: os.remove(f)
+            files, level = merged, level + 1
+         pool.close()
+         pool.join()
+         ir.merge(IR.load(files[0]))
+      finally:
+         pool.terminate()
+         shutil.rmtree(tmpdir, ignore_errors=True)
+      return ir
+
    def output_and_return_ir(self):
       """writes output if the 'output' attribute is set, then returns"""
       output = getattr(self, 'output', None)
       if output:
          self.ir.save(output)
+         self.record_output(True)
       return self.ir
 
    def process(self, ir, **kwds):
@@ -123,10 +277,82 @@ class Processor(Parametrized):
       # write to output (if given) and return IR
       return self.output_and_return_ir()
 
+   def stage(self, ir):
+      """Return a Stage doing the work of this processor on the given IR
+      as part of a fused traversal (see Composite.fuse), or None if
+      the processor needs to see the whole IR at once. Parameters are set
+      before this is called."""
+
+      return None
+
+class Stage(object):
+   """A processor's part in a single traversal of the ASG shared by
+   several processors. A stage sees each declaration in turn, depth-first,
+   together with the list of its enclosing scopes and groups, outermost
+   first. It only sees the declarations kept by the stages before it, and
+   it may only modify those: the stages after it see each declaration
+   right after it does, not after it has seen the whole ASG."""
+
+   def enter(self, declaration, scopes):
+      """Called before the content of the declaration, if any, is visited.
+      Return False to remove the declaration, with its content."""
+
+      return True
+
+   def leave(self, declaration, scopes, declarations):
+      """Called after the content of a scope or group was visited, with the
+      declarations this stage and the ones before it kept, in order. The
+      declaration's 'declarations' already hold the ones all stages kept.
+      Return False to remove the declaration."""
+
+      return True
+
+   def finish(self, ir):
+      """Called once the traversal is done."""
+
+      pass
+
+def run_stages(ir, stages):
+   """Run the given stages in a single traversal of the ASG."""
+
+   count = len(stages)
+   # Only call 'leave' for the stages that implement it.
+   leaving = [i for i in range(count)
+              if type(stages[i]).leave.im_func is not Stage.leave.im_func]
+
+   def visit(declarations, scopes):
+      """Visit the declarations, returning a list of (declaration, stage)
+      pairs, with the index of the stage that removed the declaration,
+      or 'count' for those kept."""
+
+      result = []
+      for d in declarations:
+         removed = count
+         for i in range(count):
+            if not stages[i].enter(d, scopes):
+               removed = i
+               break
+         if removed == count and isinstance(d, (ASG.Scope, ASG.Group)):
+            content = visit(d.declarations, scopes + [d])
+            d.declarations[:] = [c for c, r in content if r == count]
+            for i in leaving:
+               kept = [c for c, r in content if r > i]
+               if not stages[i].leave(d, scopes, kept):
+                  removed = i
+                  break
+         result.append((d, removed))
+      return result
+
+   declarations = ir.asg.declarations
+   declarations[:] = [d for d, r in visit(declarations, []) if r == count]
+   for s in stages:
+      s.finish(ir)
+
 class Composite(Processor):
    """A Composite processor."""
 
    processors = Parameter([], 'the list of processors this is composed of')
+   fuse = Parameter(False, 'run consecutive processors that support it in a single traversal of the ASG')
 
    def __init__(self, *processors, **kwds):
       """This __init__ is a convenience constructor that takes a var list
@@ -136,49 +362,93 @@ class Composite(Processor):
       self.set_parameters(kwds)
 
    def process(self, ir, **kwds):
-      """apply a list of processors. The 'input' value is passed to the first
-      processor only, the 'output' to the last. 'verbose' and 'debug' are
-      passed down if explicitely given as named values.
-      All other keywords are ignored."""
+      """apply a list of processors. The 'input' and 'jobs' values are passed
+      to the first processor only, the 'output' to the last. 'verbose' and 'debug' are
+      passed down if explicitely given as named values, as is 'manifest'.
+      If the manifest shows the 'output' to be up to date, and 'ir' is
+      empty, nothing is processed. If 'fuse' is set, processors are run as stages of shared
+      traversals where possible. All other keywords are ignored."""
 
       if not self.processors:
          return super(Composite, self).process(ir, **kwds)
 
       self.set_parameters(kwds)
 
-      if len(self.processors) == 1:
-         my_kwds = {}
-         if self.input: my_kwds['input'] = self.input
-         if self.output: my_kwds['output'] = self.output
-         if self.verbose: my_kwds['verbose'] = self.verbose
-         if self.debug: my_kwds['debug'] = self.debug
-         if self.profile: my_kwds['profile'] = self.profile
-         return self.processors[0].process(ir, **my_kwds)
-
-      # more than one processor...
-      # call the first, passing the 'input' parameter, if present
-      my_kwds = {}
-      if self.input: my_kwds['input'] = self.input
-      if self.verbose: my_kwds['verbose'] = self.verbose
-      if self.debug: my_kwds['debug'] = self.debug
-      if self.profile: my_kwds['profile'] = self.profile
-      ir = self.processors[0].process(ir, **my_kwds)
-
-      # deal with all between the first and the last;
-      # they only get 'verbose', 'debug', and 'profile' flags
-      my_kwds = {}
-      if self.verbose: my_kwds['verbose'] = self.verbose
-      if self.debug: my_kwds['debug'] = self.debug
-      if self.profile: my_kwds['profile'] = self.profile
-      if len(self.processors) > 2:
-         for p in self.processors[1:-1]:
-            ir = p.process(ir, **my_kwds)
-
-      # call the last, passing the 'output' parameter, if present
-      if self.output: my_kwds['output'] = self.output
-      ir = self.processors[-1].process(ir, **my_kwds)
+      if self.output_is_current(ir):
+         if self.verbose: print "'%s' is up to date"%self.output
+         if self.get_manifest().is_ir(self.output):
+            return IR.load(self.output)
+         return ir
+
+      if self.fuse:
+         ir = self.process_fused(ir)
+      else:
+         for i in range(len(self.processors)):
+            ir = self.processors[i].process(ir, **self.processor_kwds(i))
+      self.record_composite_output()
+      return ir
 
+   def processor_kwds(self, i):
+      """Return the keywords to pass to the i'th processor. The 'input'
+      and 'jobs' values are passed to the first processor only, the
+      'output' to the last."""
+
+      kwds = {}
+      if i == 0:
+         if self.input: kwds['input'] = self.input
+         if self.jobs > 1: kwds['jobs'] = self.jobs
+      if i == len(self.processors) - 1:
+         if self.output: kwds['output'] = self.output
+      if self.verbose: kwds['verbose'] = self.verbose
+      if self.debug: kwds['debug'] = self.debug
+      if self.profile: kwds['profile'] = self.profile
+      if self.manifest: kwds['manifest'] = self.manifest
+      return kwds
+
+   def process_fused(self, ir):
+      """Apply the processors, running consecutive ones that provide a
+      Stage in a single traversal. Processors that don't, as well as those
+      reading input or writing output, are run on their own."""
+
+      stages, traversals, fused = [], 0, 0
+      for i in range(len(self.processors) + 1):
+         stage = None
+         if i < len(self.processors):
+            p = self.processors[i]
+            kwds = self.processor_kwds(i)
+            if 'input' not in kwds and 'output' not in kwds:
+               p.set_parameters(kwds)
+               if not p.input and not p.output:
+                  stage = p.stage(ir)
+            if stage is not None:
+               stages.append(stage)
+               continue
+         if stages:
+            zone = Profiler.zone('fused traversal')
+            try:
+               run_stages(ir, stages)
+               Profiler.count('stages', len(stages))
+            finally:
+               zone.end()
+            traversals += 1
+            fused += len(stages)
+            stages = []
+         if i < len(self.processors):
+            ir = p.process(ir, **kwds)
+
+      saved = fused - traversals
+      Profiler.count('passes saved', saved)
+      if self.verbose:
+         print 'fused %d processors into %d traversals, saving %d passes'%(fused, traversals, saved)
       return ir
+
+   def record_composite_output(self):
+      """Record the composite's 'input' as the origin of its 'output',
+      which the processor generating it may have stored as IR."""
+
+      manifest = self.get_manifest()
+      if manifest and self.output:
+         self.record_output(manifest.is_ir(self.output))
    
 class Store(Processor):
    """Store is a convenience class useful to write out the intermediate
@@ -6,7 +6,7 @@
 # see the file COPYING for details.
 #
 
-from Synopsis.Processor import Processor, Parameter
+from Synopsis.Processor import Processor, Stage, Parameter
 from Synopsis import ASG
 
 class AccessRestrictor(Processor, ASG.Visitor):
@@ -28,12 +28,16 @@ class AccessRestrictor(Processor, ASG.Visitor):
 
       if self.access is not None:
 
-         for decl in ir.asg.declarations:
-            decl.accept(self)
+         ASG.walk(self, ir.asg.declarations)
          ir.asg.declarations = self.__currscope
 
       return self.output_and_return_ir()
 
+   def stage(self, ir):
+
+      if self.access is None: return Stage()
+      return AccessStage(self.access)
+
    def push(self):
 
       self.__scopestack.append(self.__currscope)
@@ -57,7 +61,26 @@ class AccessRestrictor(Processor, ASG.Visitor):
 
       if scope.accessibility > self.access: return
       self.push()
-      for decl in scope.declarations:
-         decl.accept(self)
+      ASG.walk(self, scope.declarations)
       scope.declarations = self.__currscope
       self.pop(scope)
+
+   visit_group = visit_scope
+
+   def visit_enum(self, enum):
+
+      # Enumerators stay in their enum.
+      self.visit_declaration(enum)
+
+class AccessStage(Stage):
+   """Run an AccessRestrictor in a fused traversal."""
+
+   def __init__(self, access):
+
+      self.access = access
+
+   def enter(self, declaration, scopes):
+
+      # Like the AccessRestrictor, drop builtins.
+      return (declaration.accessibility <= self.access and
+              not isinstance(declaration, ASG.Builtin))
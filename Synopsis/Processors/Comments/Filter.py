@@ -18,8 +18,7 @@ class Filter(Processor, ASG.Visitor):
 
         self.ir = self.merge_input(ir)
 
-        for d in ir.asg.declarations:
-            d.accept(self)
+        ASG.walk(self, ir.asg.declarations)
 
         return self.output_and_return_ir()
 
@@ -136,7 +136,7 @@ class Grouper(Transformer):
 
         self.process_comments(scope)
         self.push()
-        for d in scope.declarations: d.accept(self)
+        ASG.walk(self, scope.declarations)
         scope.declarations = self.current_scope()
         self.pop(scope)
 
@@ -146,8 +146,7 @@ class Grouper(Transformer):
 
         self.process_comments(enum)
         self.push()
-        for enumor in enum.enumerators:
-            enumor.accept(self)
+        ASG.walk(self, enum.enumerators)
         enum.enumerators = self.current_scope()
         self.pop(enum)
 
@@ -0,0 +1,144 @@
+#
+# Copyright (C) 2011 Stefan Seefeld
+# All rights reserved.
+# Licensed to the public under the terms of the GNU LGPL (>= 2),
+# see the file COPYING for details.
+#
+
+from Synopsis import ASG
+from Synopsis.Processor import Parameter
+from Filter import *
+from Previous import Previous
+from Grouper import Grouper
+from Translator import Translator
+
+class Pipeline(Grouper):
+    """A Pipeline filters comments, moves comments to previous declarations,
+    groups declarations and translates comments into documentation,
+    all in a single traversal of the ASG. The result is the same as that of
+
+      Translator(filter=filter, processor=Composite(Previous(), Grouper()))
+
+    (leaving out Previous or Grouper if 'previous' or 'group' are False),
+    without the separate passes over all declarations."""
+
+    filter = Parameter(SSFilter(), 'A comment filter to apply.')
+    previous = Parameter(True, "Whether to move comments starting with '<' to the previous declaration.")
+    group = Parameter(True, 'Whether to group declarations enclosed by grouping tags.')
+    markup = Parameter('', 'The markup type for this declaration.')
+    concatenate = Parameter(False, 'Whether or not to concatenate adjacent comments.')
+    primary_only = Parameter(True, 'Whether or not to preserve secondary comments.')
+
+    def process(self, ir, **kwds):
+
+        self.set_parameters(kwds)
+        self.ir = self.merge_input(ir)
+
+        self.__previous = Previous(debug=self.debug)
+        self.__translator = Translator(filter=None,
+                                       markup=self.markup,
+                                       concatenate=self.concatenate,
+                                       primary_only=self.primary_only)
+        self.visit_declarations(self.ir.asg.declarations)
+
+        self.finalize()
+        return self.output_and_return_ir()
+
+    def visit_declarations(self, declarations, eos = None):
+        """Process a list of sibling declarations, followed by an optional
+        end-of-scope marker. As a declaration's comment may be moved to
+        its predecessor, declarations are only completed (grouped and
+        translated) once their successor has been seen."""
+
+        last = None
+        for d in declarations:
+            self.filter_and_move(d, last)
+            if last is not None: last.accept(self)
+            last = d
+        if eos is not None:
+            self.filter_and_move(eos, last)
+        if last is not None: last.accept(self)
+
+    def filter_and_move(self, decl, last):
+        """Filter the comments of 'decl', and move its first comment
+        to 'last' if it starts with '<'."""
+
+        comments = decl.annotations.get('comments')
+        if not comments: return
+        if self.filter:
+            filter_comment = self.filter.filter_comment
+            comments[:] = [c is not None and filter_comment(c) or None
+                           for c in comments]
+        first = comments[0]
+        if (self.previous and first and first[0] == '<' and
+            last is not None and self.takes_previous(decl)):
+            self.__previous.last = last
+            self.__previous.process_comments(decl)
+
+    def takes_previous(self, decl):
+        """Return True if Previous checks the comments of 'decl'."""
+
+        if isinstance(decl, ASG.Builtin): return decl.type == 'EOS'
+        return not isinstance(decl, (ASG.Scope, ASG.Enum))
+
+    def process_comments(self, decl):
+        """Look for grouping tags, which need a brace. The (common) case
+        of comments without any is handled without matching them."""
+
+        comments = decl.annotations.get('comments')
+        if comments:
+            for c in comments:
+                if c and ('{' in c or '}' in c):
+                    Grouper.process_comments(self, decl)
+                    return
+        else:
+            decl.annotations['comments'] = []
+
+    def translate(self, decl):
+
+        if decl.annotations.get('comments'):
+            self.__translator.visit_declaration(decl)
+
+    def push_group(self, group):
+
+        self.translate(group)
+        Grouper.push_group(self, group)
+
+    def visit_declaration(self, decl):
+
+        if self.group: self.process_comments(decl)
+        self.translate(decl)
+        self.add(decl)
+
+    def visit_builtin(self, decl):
+
+        if self.group: self.process_comments(decl)
+        self.add(decl)
+
+    def visit_scope(self, scope):
+
+        if self.group: self.process_comments(scope)
+        self.translate(scope)
+        self.push()
+        self.visit_declarations(scope.declarations)
+        scope.declarations = self.current_scope()
+        self.pop(scope)
+
+    visit_group = visit_scope
+
+    def visit_enum(self, enum):
+
+        if self.group: self.process_comments(enum)
+        self.translate(enum)
+        self.push()
+        self.visit_declarations(enum.enumerators, enum.eos)
+        enum.enumerators = self.current_scope()
+        self.pop(enum)
+
+    def visit_enumerator(self, enumor):
+
+        # Grouper drops dummy enumerators.
+        if self.group and (enumor.type == "dummy" or not len(enumor.name)):
+            return
+        self.translate(enumor)
+        self.add(enumor)
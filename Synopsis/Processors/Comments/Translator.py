@@ -28,8 +28,7 @@ class Translator(Processor, ASG.Visitor):
         if self.processor:
             self.ir = self.processor.process(self.ir)
 
-        for decl in self.ir.asg.declarations:
-            decl.accept(self)
+        ASG.walk(self, self.ir.asg.declarations)
 
         return self.output_and_return_ir()
 
@@ -42,7 +41,7 @@ class Translator(Processor, ASG.Visitor):
             text = None
             if self.primary_only:
                 text = comments[-1]
-            elif self.combine:
+            elif self.concatenate:
                 text = ''.join([c for c in comments if c])
             else:
                 comments = comments[:]
@@ -2,3 +2,4 @@ from Filter     import *
 from Previous   import Previous
 from Grouper    import Grouper
 from Translator import Translator
+from Pipeline   import Pipeline
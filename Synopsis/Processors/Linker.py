@@ -7,19 +7,32 @@
 #
 
 from Synopsis.Processor import Composite, Parameter
-from Synopsis import ASG
+from Synopsis import IR, ASG
 from Synopsis.QualifiedName import *
+try:
+   import LinkerImpl
+except ImportError:
+   LinkerImpl = None
 
 class Linker(Composite, ASG.Visitor):
-   """Visitor that removes duplicate declarations"""
+   """Visitor that removes duplicate declarations.
+   If 'native' is set and the `LinkerImpl` extension module was built,
+   declarations are linked by its native implementation of the visitor,
+   unless a subclass overrides any of the visit methods."""
 
    remove_empty_modules = Parameter(True, 'Remove empty modules.')
    sort_modules = Parameter(True, 'Sort module content alphabetically.')
    sxr_prefix = Parameter('', 'Compile sxr data, if defined.')
+   native = Parameter(False, 'Use the native linker, if available.')
 
    def process(self, ir, **kwds):
 
       self.set_parameters(kwds)
+      # The whole IR is linked again if any input changed; the results of
+      # re-parsed translation units aren't spliced into the previous output.
+      if self.output_is_current(ir):
+         if self.verbose: print "'%s' is up to date"%self.output
+         return IR.load(self.output)
       self.ir = self.merge_input(ir)
 
       root = ASG.MetaModule("", QualifiedName())
@@ -29,18 +42,24 @@ class Linker(Composite, ASG.Visitor):
       self.__dicts = [global_dict]
 
       self.types = self.ir.asg.types
+      native = self.native and self.is_native()
       
       try:
-         for d in self.ir.asg.declarations:
-            d.accept(self)
+         if native:
+            root.declarations = LinkerImpl.link(self.ir.asg.declarations, self.types)
+         else:
+            ASG.walk(self, self.ir.asg.declarations)
          self.ir.asg.declarations = root.declarations
       except TypeError, e:
          import traceback
          traceback.print_exc()
          print 'linker error :', e
 
-      for file in self.ir.files.values():
-         self.visit_source_file(file)
+      if native:
+         LinkerImpl.link_files(self.ir.files.values(), self.types)
+      else:
+         for file in self.ir.files.values():
+            self.visit_source_file(file)
 
       if self.remove_empty_modules:
          import ModuleFilter
@@ -61,6 +80,17 @@ class Linker(Composite, ASG.Visitor):
       
       return self.output_and_return_ir()
 
+   def is_native(self):
+      """Return True if the native linker can be used, i.e. if it is
+      available and the visitor methods weren't overridden."""
+
+      if not LinkerImpl: return False
+      for name in dir(Linker):
+         if (name.startswith('visit_') and
+             getattr(type(self), name) != getattr(Linker, name)):
+            return False
+      return True
+
    def lookup(self, name):
       """look whether the current scope already contains
       a declaration with the given name"""
@@ -143,16 +173,20 @@ class Linker(Composite, ASG.Visitor):
 
    def visit_modifier_type_id(self, type):
 
+      # Modifier and array type-ids may be shared (see ASG.intern_type_id),
+      # so their alias isn't changed. The linked type-id is a new one.
       alias = self.link_type(type.alias)
       if alias is not type.alias:
-         type.alias = alias
+         type = ASG.intern_type_id(ASG.ModifierTypeId(type.language, alias,
+                                                      type.premod, type.postmod))
       self.__type = type
 
    def visit_array_type_id(self, type):
 
       alias = self.link_type(type.alias)
       if alias is not type.alias:
-         type.alias = alias
+         type = ASG.intern_type_id(ASG.ArrayTypeId(type.language, alias,
+                                                   type.sizes))
       self.__type = type
 
    def visit_parametrized_type_id(self, type):
@@ -182,6 +216,8 @@ class Linker(Composite, ASG.Visitor):
       # Clear the list and refill it
       declarations = file.declarations
       file.declarations = []
+      # Declarations compare by identity.
+      seen = set()
 
       for d in declarations:
          # If this is a forward declaration try to
@@ -191,7 +227,8 @@ class Linker(Composite, ASG.Visitor):
             if isinstance(declared, ASG.DeclaredTypeId):
                d = declared.declaration
          # ...and only declare it once.
-         if d not in file.declarations:
+         if id(d) not in seen:
+            seen.add(id(d))
             file.declarations.append(d)
         
       # TODO: includes.
@@ -212,27 +249,27 @@ class Linker(Composite, ASG.Visitor):
       self.merge_comments(metamodule, module)
 
       self.push(metamodule)
-      for d in module.declarations:
-         d.accept(self)
+      ASG.walk(self, module.declarations)
       module.declarations = []
       self.pop()
 
 
    def visit_group(self, group):
 
+      declarations = group.declarations
       previous = self.lookup(group.name)
       if not previous:
+         group.declarations = []
          self.append(group)
       elif isinstance(previous, ASG.Group):
-         previous.declarations.append(group.declarations)
          self.merge_comments(previous, group)
          group = previous
       else:
          raise TypeError, 'symbol type mismatch: Synopsis.ASG.Group and %s both match "%s"'%(previous.__class__, str(previous.name))
 
+      # Link the group's declarations into the (possibly merged) group.
       self.push(group)
-      for d in group.declarations:
-         d.accept(self)
+      ASG.walk(self, declarations)
       self.pop()
 
 
@@ -260,8 +297,7 @@ class Linker(Composite, ASG.Visitor):
       metamodule.module_declarations.extend(module.module_declarations)
       self.merge_comments(metamodule, module)
       self.push(metamodule)
-      for d in module.declarations:
-         d.accept(self)
+      ASG.walk(self, module.declarations)
       module.declarations = []
       self.pop()
 
@@ -354,13 +390,11 @@ class Linker(Composite, ASG.Visitor):
          else:
             raise TypeError, 'symbol type mismatch: Synopsis.ASG.Class and %s both match "%s"'%(prev.__class__, '::'.join(class_.name))
       self.add_declaration(class_)
-      for p in class_.parents:
-         p.accept(self)
+      ASG.walk(self, class_.parents)
       declarations = class_.declarations
       class_.declarations = []
       self.push(class_)
-      for d in declarations:
-         d.accept(self)
+      ASG.walk(self, declarations)
       self.pop()
 
    def visit_inheritance(self, parent):
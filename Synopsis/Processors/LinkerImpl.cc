@@ -0,0 +1,731 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#include <boost/python.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace bpl = boost::python;
+
+namespace
+{
+
+//. What the linker does with a node, depending on the visitor method its
+//. 'accept' method calls (directly, or through the ASG.Visitor defaults).
+enum Kind
+{
+  UNKNOWN,
+  // declarations
+  DECLARATION, BUILTIN, GROUP, SCOPE, MODULE, META_MODULE, CLASS, TYPEDEF,
+  VARIABLE, CONST, FUNCTION, INHERITANCE,
+  // type-ids
+  NAMED_TYPE, DECLARED_TYPE, TEMPLATE_ID, MODIFIER_TYPE, ARRAY_TYPE,
+  PARAMETRIZED_TYPE, FUNCTION_TYPE, OTHER_TYPE
+};
+
+struct Accept
+{
+  char const *type;
+  Kind        kind;
+};
+
+Accept const accepts[] =
+{
+  {"Declaration", DECLARATION},
+  {"Builtin", BUILTIN},
+  {"UsingDirective", BUILTIN},
+  {"UsingDeclaration", BUILTIN},
+  {"Macro", DECLARATION},
+  {"Forward", DECLARATION},
+  {"Group", GROUP},
+  {"Scope", SCOPE},
+  {"Module", MODULE},
+  {"MetaModule", META_MODULE},
+  {"Inheritance", INHERITANCE},
+  {"Class", CLASS},
+  {"ClassTemplate", CLASS},
+  {"Typedef", TYPEDEF},
+  {"Enumerator", DECLARATION},
+  {"Enum", DECLARATION},
+  {"Variable", VARIABLE},
+  {"Const", CONST},
+  {"Function", FUNCTION},
+  {"FunctionTemplate", FUNCTION},
+  {"Operation", FUNCTION},
+  {"OperationTemplate", FUNCTION},
+  {"TypeId", OTHER_TYPE},
+  {"BuiltinTypeId", NAMED_TYPE},
+  {"DependentTypeId", OTHER_TYPE},
+  {"UnknownTypeId", NAMED_TYPE},
+  {"DeclaredTypeId", DECLARED_TYPE},
+  {"TemplateId", TEMPLATE_ID},
+  {"ModifierTypeId", MODIFIER_TYPE},
+  {"ArrayTypeId", ARRAY_TYPE},
+  {"ParametrizedTypeId", PARAMETRIZED_TYPE},
+  {"FunctionTypeId", FUNCTION_TYPE}
+};
+
+bool isinstance(bpl::object o, bpl::object type)
+{
+  int result = PyObject_IsInstance(o.ptr(), type.ptr());
+  if (result < 0) bpl::throw_error_already_set();
+  return result;
+}
+
+bool is(bpl::object a, bpl::object b) { return a.ptr() == b.ptr();}
+
+void print(bpl::object message)
+{
+  bpl::import("sys").attr("stdout").attr("write")(message + "\n");
+}
+
+void raise_type_error(bpl::object message)
+{
+  PyErr_SetObject(PyExc_TypeError, message.ptr());
+  bpl::throw_error_already_set();
+}
+
+//. The link step of Synopsis.Processors.Linker. Nodes are dispatched
+//. through a table mapping their 'accept' method to what needs to be done
+//. with them, while nodes with other 'accept' methods are visited through
+//. the Python visitor interface.
+//. Symbol tables are hash-based dictionaries, so declarations are merged in
+//. linear time.
+class Linker
+{
+public:
+  Linker(bpl::object types)
+    : asg_(bpl::import("Synopsis.ASG")),
+      types_(types),
+      forward_(asg_.attr("Forward")),
+      group_(asg_.attr("Group")),
+      meta_module_(asg_.attr("MetaModule")),
+      class_type_(asg_.attr("Class")),
+      class_template_(asg_.attr("ClassTemplate")),
+      function_(asg_.attr("Function")),
+      unknown_type_id_(asg_.attr("UnknownTypeId")),
+      declared_type_id_(asg_.attr("DeclaredTypeId")),
+      modifier_type_id_(asg_.attr("ModifierTypeId")),
+      array_type_id_(asg_.attr("ArrayTypeId")),
+      parametrized_type_id_(asg_.attr("ParametrizedTypeId")),
+      intern_type_id_(asg_.attr("intern_type_id"))
+  {
+    for (size_t i = 0; i != sizeof(accepts)/sizeof(Accept); ++i)
+    {
+      bpl::object accept = asg_.attr(accepts[i].type).attr("accept");
+      bpl::object function = bpl::getattr(accept, "im_func", accept);
+      accepts_[function.ptr()] = accepts[i].kind;
+      functions_.push_back(function);
+    }
+  }
+
+  //. Link the given declarations, returning the declarations of the
+  //. global scope they are merged into.
+  bpl::object link(bpl::object declarations)
+  {
+    self_ = bpl::object(bpl::ptr(this));
+    bpl::object qname = bpl::import("Synopsis.QualifiedName").attr("QualifiedName");
+    bpl::object root = meta_module_("", qname());
+    push(root);
+    for (long i = 0; i < bpl::len(declarations); ++i)
+      visit(declarations[i]);
+    pop();
+    compact();
+    self_ = bpl::object();
+    return root.attr("declarations");
+  }
+
+  //. Replace forward declarations in the file's declarations by their
+  //. definitions, and remove duplicates.
+  void link_file(bpl::object file)
+  {
+    bpl::object declarations = file.attr("declarations");
+    bpl::list linked;
+    file.attr("declarations") = linked;
+    // Declarations compare by identity.
+    std::set<PyObject *> seen;
+    for (long i = 0; i < bpl::len(declarations); ++i)
+    {
+      bpl::object d = declarations[i];
+      PyObject *declared = lookup_type(d.attr("name"));
+      if (declared && isinstance(bpl::object(bpl::handle<>(bpl::borrowed(declared))),
+                                 declared_type_id_))
+        d = bpl::object(bpl::handle<>(bpl::borrowed(declared))).attr("declaration");
+      if (seen.insert(d.ptr()).second)
+        linked.append(d);
+    }
+  }
+
+  // The visitor interface, used by nodes with unknown 'accept' methods.
+  void visit_builtin_type_id(bpl::object t) { type_ = link_named_type(t);}
+  void visit_unknown_type_id(bpl::object t) { type_ = link_named_type(t);}
+  void visit_declared_type_id(bpl::object t) { type_ = link_declared_type(t);}
+  void visit_template_id(bpl::object t) { type_ = link_template_id(t);}
+  void visit_modifier_type_id(bpl::object t) { type_ = link_modifier_type(t);}
+  void visit_array_type_id(bpl::object t) { type_ = link_array_type(t);}
+  void visit_parametrized_type_id(bpl::object t) { type_ = link_parametrized_type(t);}
+  void visit_function_type_id(bpl::object t) { type_ = link_function_type(t);}
+  void visit_dependent_type_id(bpl::object) {}
+
+  void visit_declaration(bpl::object d) { add_declaration(d);}
+  void visit_builtin(bpl::object d) { append(top(), d);}
+  void visit_group(bpl::object);
+  void visit_scope(bpl::object);
+  void visit_module(bpl::object);
+  void visit_meta_module(bpl::object);
+  void visit_class(bpl::object);
+  void visit_typedef(bpl::object);
+  void visit_variable(bpl::object);
+  void visit_const(bpl::object);
+  void visit_function(bpl::object);
+  void visit_parameter(bpl::object);
+  void visit_inheritance(bpl::object);
+
+private:
+  struct Scope
+  {
+    bpl::object scope;
+    bpl::object declarations;
+    //. Map from name to declaration.
+    bpl::dict   symbols;
+    //. The names of the functions declared in this scope.
+    bpl::dict   functions;
+    //. Declarations replaced in this scope, to be removed from its
+    //. declarations by compact(). Removing them one at a time would take
+    //. time linear in the size of the scope each.
+    std::map<PyObject *, long> removed;
+  };
+  typedef std::map<PyObject *, Scope> Scopes;
+  typedef std::map<PyObject *, Kind> Kinds;
+
+  Kind kind(bpl::object o)
+  {
+    PyTypeObject *type = Py_TYPE(o.ptr());
+    Kinds::iterator i = kinds_.find((PyObject *)type);
+    if (i != kinds_.end()) return i->second;
+    bpl::object t(bpl::handle<>(bpl::borrowed((PyObject *)type)));
+    bpl::object accept = bpl::getattr(t, "accept", bpl::object());
+    Kind k = UNKNOWN;
+    if (!accept.is_none())
+    {
+      i = accepts_.find(bpl::getattr(accept, "im_func", accept).ptr());
+      if (i != accepts_.end()) k = i->second;
+    }
+    types_seen_.push_back(t);
+    return kinds_[(PyObject *)type] = k;
+  }
+
+  void visit(bpl::object d)
+  {
+    switch (kind(d))
+    {
+      case DECLARATION: add_declaration(d); break;
+      case BUILTIN: visit_builtin(d); break;
+      case GROUP: visit_group(d); break;
+      case SCOPE: visit_scope(d); break;
+      case MODULE: visit_module(d); break;
+      case META_MODULE: visit_meta_module(d); break;
+      case CLASS: visit_class(d); break;
+      case TYPEDEF: visit_typedef(d); break;
+      case VARIABLE: visit_variable(d); break;
+      case CONST: visit_const(d); break;
+      case FUNCTION: visit_function(d); break;
+      case INHERITANCE: visit_inheritance(d); break;
+      default: d.attr("accept")(self_); break;
+    }
+  }
+
+  //. Return the linked type-id for 't'.
+  bpl::object link_type(bpl::object t)
+  {
+    if (t.is_none()) return t;
+    switch (kind(t))
+    {
+      case NAMED_TYPE: return link_named_type(t);
+      case DECLARED_TYPE: return link_declared_type(t);
+      case TEMPLATE_ID: return link_template_id(t);
+      case MODIFIER_TYPE: return link_modifier_type(t);
+      case ARRAY_TYPE: return link_array_type(t);
+      case PARAMETRIZED_TYPE: return link_parametrized_type(t);
+      case FUNCTION_TYPE: return link_function_type(t);
+      case OTHER_TYPE: return t;
+      default:
+      {
+        type_ = t;
+        t.attr("accept")(self_);
+        bpl::object result = type_;
+        type_ = bpl::object();
+        return result;
+      }
+    }
+  }
+
+  //. Return the type-id registered for the given name, or 0.
+  PyObject *lookup_type(bpl::object name)
+  {
+    if (PyDict_Check(types_.ptr())) return PyDict_GetItem(types_.ptr(), name.ptr());
+    bpl::object t = bpl::getattr(types_, "get")(name);
+    return t.is_none() ? 0 : t.ptr();
+  }
+
+  bpl::object link_named_type(bpl::object t)
+  {
+    PyObject *linked = lookup_type(t.attr("name"));
+    return linked ? bpl::object(bpl::handle<>(bpl::borrowed(linked))) : t;
+  }
+
+  bpl::object link_declared_type(bpl::object t)
+  {
+    PyObject *linked = lookup_type(t.attr("name"));
+    if (linked) return bpl::object(bpl::handle<>(bpl::borrowed(linked)));
+    print("Couldn't find declared type-id: " + bpl::str(bpl::object(t.attr("name"))));
+    return t;
+  }
+
+  bpl::object link_template_id(bpl::object t)
+  {
+    bpl::object name = t.attr("name");
+    PyObject *linked = lookup_type(name);
+    if (!linked) return t;
+    bpl::object declared(bpl::handle<>(bpl::borrowed(linked)));
+    if (isinstance(declared, unknown_type_id_))
+      // The type was declared in a file for which no ASG is retained.
+      return t;
+    else if (!isinstance(declared, declared_type_id_))
+    {
+      print("Warning: template declaration was not a declaration: " +
+            bpl::str(name) + " " + bpl::str(bpl::object(declared.attr("__class__").attr("__name__"))));
+      return t;
+    }
+    bpl::object decl = declared.attr("declaration");
+    if (!PyObject_HasAttrString(decl.ptr(), "template")) return t;
+    bpl::object templ = decl.attr("template");
+    if (templ) return templ;
+    print("Warning: template type disappeared: " + bpl::str(name));
+    return t;
+  }
+
+  //. Modifier and array type-ids may be shared (see ASG.intern_type_id),
+  //. so instead of changing their alias, return the type-id with the
+  //. linked alias.
+  bpl::object link_modifier_type(bpl::object t)
+  {
+    bpl::object alias = t.attr("alias");
+    bpl::object linked = link_type(alias);
+    if (is(linked, alias)) return t;
+    bpl::object language = t.attr("language");
+    bpl::object premod = t.attr("premod");
+    bpl::object postmod = t.attr("postmod");
+    return intern_type_id_(modifier_type_id_(language, linked, premod, postmod));
+  }
+
+  bpl::object link_array_type(bpl::object t)
+  {
+    bpl::object alias = t.attr("alias");
+    bpl::object linked = link_type(alias);
+    if (is(linked, alias)) return t;
+    bpl::object language = t.attr("language");
+    bpl::object sizes = t.attr("sizes");
+    return intern_type_id_(array_type_id_(language, linked, sizes));
+  }
+
+  bpl::object link_parametrized_type(bpl::object t)
+  {
+    bpl::object templ = t.attr("template");
+    bpl::object linked = link_type(templ);
+    if (!is(linked, templ)) t.attr("template") = linked;
+    t.attr("parameters") = link_types(t.attr("parameters"));
+    return t;
+  }
+
+  bpl::object link_function_type(bpl::object t)
+  {
+    bpl::object ret = t.attr("return_type");
+    bpl::object linked = link_type(ret);
+    if (!is(linked, ret)) t.attr("return_type") = linked;
+    t.attr("parameters") = link_types(t.attr("parameters"));
+    return t;
+  }
+
+  bpl::list link_types(bpl::object types)
+  {
+    bpl::list linked;
+    for (long i = 0; i < bpl::len(types); ++i)
+      linked.append(link_type(types[i]));
+    return linked;
+  }
+
+  Scope &top() { return *stack_.back();}
+
+  void push(bpl::object scope)
+  {
+    Scope &s = scopes_[scope.ptr()];
+    if (s.scope.is_none()) s.scope = scope;
+    s.declarations = scope.attr("declarations");
+    stack_.push_back(&s);
+  }
+
+  void pop() { stack_.pop_back();}
+
+  //. Remove a declaration from the scope. This is deferred until compact(),
+  //. which drops the first occurrences, like list.remove would have.
+  void remove(Scope &s, bpl::object d) { ++s.removed[d.ptr()];}
+
+  //. Remove the declarations replaced in all scopes.
+  void compact()
+  {
+    for (Scopes::iterator i = scopes_.begin(); i != scopes_.end(); ++i)
+    {
+      Scope &s = i->second;
+      if (s.removed.empty()) continue;
+      bpl::list declarations;
+      for (long j = 0; j < bpl::len(s.declarations); ++j)
+      {
+        bpl::object d = s.declarations[j];
+        std::map<PyObject *, long>::iterator r = s.removed.find(d.ptr());
+        if (r != s.removed.end() && r->second)
+          --r->second;
+        else
+          declarations.append(d);
+      }
+      s.declarations.slice(bpl::_, bpl::_) = declarations;
+      s.removed.clear();
+    }
+  }
+
+  bpl::object lookup(bpl::object name) { return top().symbols.get(name);}
+
+  //. Append the declaration to the scope, without declaring its name.
+  void append(Scope &s, bpl::object d)
+  {
+    s.declarations.attr("append")(d);
+    if (isinstance(d, function_))
+      s.functions[bpl::object(d.attr("name"))] = true;
+  }
+
+  //. Append the declaration to the scope, declaring its name.
+  void declare(bpl::object d)
+  {
+    append(top(), d);
+    top().symbols[bpl::object(d.attr("name"))] = d;
+  }
+
+  //. Add a declaration to the current scope. If there is already a
+  //. forward declaration, it is replaced, unless this is also a forward
+  //. declaration.
+  void add_declaration(bpl::object d)
+  {
+    bpl::object name = d.attr("name");
+    Scope &s = top();
+    bpl::object prev = s.symbols.get(name);
+    if (!prev.is_none())
+    {
+      if (!isinstance(prev, forward_)) return;
+      if (!isinstance(d, forward_))
+      {
+        remove(s, prev);
+        append(s, d);
+        s.symbols[name] = d;
+      }
+      return;
+    }
+    append(s, d);
+    s.symbols[name] = d;
+  }
+
+  void merge_comments(bpl::object metamodule, bpl::object module);
+
+  bpl::object      asg_;
+  bpl::object      types_;
+  bpl::object      forward_;
+  bpl::object      group_;
+  bpl::object      meta_module_;
+  bpl::object      class_type_;
+  bpl::object      class_template_;
+  bpl::object      function_;
+  bpl::object      unknown_type_id_;
+  bpl::object      declared_type_id_;
+  bpl::object      modifier_type_id_;
+  bpl::object      array_type_id_;
+  bpl::object      parametrized_type_id_;
+  bpl::object      intern_type_id_;
+  bpl::object      self_;
+  //. The type-id set by the visit_*_type_id methods.
+  bpl::object      type_;
+  std::map<PyObject *, Kind> accepts_;
+  std::vector<bpl::object>   functions_;
+  Kinds                      kinds_;
+  std::vector<bpl::object>   types_seen_;
+  Scopes                     scopes_;
+  std::vector<Scope *>       stack_;
+};
+
+void Linker::visit_group(bpl::object group)
+{
+  bpl::object declarations = group.attr("declarations");
+  bpl::object previous = lookup(group.attr("name"));
+  if (previous.is_none())
+  {
+    group.attr("declarations") = bpl::list();
+    declare(group);
+  }
+  else if (isinstance(previous, group_))
+  {
+    merge_comments(previous, group);
+    group = previous;
+  }
+  else
+    raise_type_error(bpl::str("symbol type mismatch: Synopsis.ASG.Group and %s both match \"%s\"") %
+                     bpl::make_tuple(bpl::object(previous.attr("__class__")),
+                                     bpl::str(bpl::object(previous.attr("name")))));
+
+  push(group);
+  for (long i = 0; i < bpl::len(declarations); ++i)
+    visit(declarations[i]);
+  pop();
+}
+
+void Linker::visit_scope(bpl::object scope)
+{
+  add_declaration(scope);
+  bpl::object declarations = scope.attr("declarations");
+  for (long i = 0; i < bpl::len(declarations); ++i)
+    visit(declarations[i]);
+}
+
+void Linker::visit_module(bpl::object module)
+{
+  bpl::object name = module.attr("name");
+  bpl::object metamodule = lookup(name);
+  if (metamodule.is_none())
+  {
+    metamodule = meta_module_(bpl::object(module.attr("type")), name);
+    declare(metamodule);
+  }
+  else if (!isinstance(metamodule, meta_module_))
+    raise_type_error(bpl::str("symbol type mismatch: Synopsis.ASG.Module and %s both match \"%s\"") %
+                     bpl::make_tuple(bpl::object(metamodule.attr("__class__")), bpl::str(name)));
+
+  metamodule.attr("module_declarations").attr("append")(module);
+  merge_comments(metamodule, module);
+
+  push(metamodule);
+  bpl::object declarations = module.attr("declarations");
+  for (long i = 0; i < bpl::len(declarations); ++i)
+    visit(declarations[i]);
+  module.attr("declarations") = bpl::list();
+  pop();
+}
+
+void Linker::visit_meta_module(bpl::object module)
+{
+  bpl::object name = module.attr("name");
+  bpl::object metamodule = lookup(name);
+  if (metamodule.is_none())
+  {
+    metamodule = meta_module_(bpl::object(module.attr("type")), name);
+    declare(metamodule);
+  }
+  else if (!isinstance(metamodule, meta_module_))
+    raise_type_error(bpl::str("symbol type mismatch: Synopsis.ASG.MetaModule and %s both match \"%s\"") %
+                     bpl::make_tuple(bpl::object(metamodule.attr("__class__")), bpl::str("::").join(name)));
+
+  metamodule.attr("module_declarations").attr("extend")(bpl::object(module.attr("module_declarations")));
+  merge_comments(metamodule, module);
+
+  push(metamodule);
+  bpl::object declarations = module.attr("declarations");
+  for (long i = 0; i < bpl::len(declarations); ++i)
+    visit(declarations[i]);
+  module.attr("declarations") = bpl::list();
+  pop();
+}
+
+void Linker::merge_comments(bpl::object metamodule, bpl::object module)
+{
+  bpl::dict annotations = bpl::extract<bpl::dict>(module.attr("annotations"));
+  if (!annotations.has_key("comments")) return;
+  bpl::object new_comments = annotations["comments"];
+  bpl::dict meta_annotations = bpl::extract<bpl::dict>(metamodule.attr("annotations"));
+  bpl::object comments = meta_annotations.setdefault("comments", bpl::list());
+  long size = bpl::len(new_comments);
+  if (comments.slice(-size, bpl::_) != new_comments)
+    comments.attr("extend")(new_comments);
+}
+
+void Linker::visit_class(bpl::object class_)
+{
+  bpl::object name = class_.attr("name");
+  bpl::object prev = lookup(name);
+  if (!prev.is_none())
+  {
+    if (isinstance(prev, forward_))
+    {
+      // Forward declaration, replace it.
+      remove(top(), prev);
+      top().symbols[name].del();
+    }
+    else if (isinstance(prev, class_type_) ||
+             isinstance(prev, class_template_))
+    {
+      // Previous class. The duplicate is ignored, except for nested
+      // classes prev may only have seen forward-declared.
+      push(prev);
+      bpl::object declarations = class_.attr("declarations");
+      for (long i = 0; i < bpl::len(declarations); ++i)
+      {
+        bpl::object d = declarations[i];
+        if (isinstance(d, class_type_) || isinstance(d, class_template_))
+          visit(d);
+      }
+      pop();
+      return;
+    }
+    else
+      raise_type_error(bpl::str("symbol type mismatch: Synopsis.ASG.Class and %s both match \"%s\"") %
+                       bpl::make_tuple(bpl::object(prev.attr("__class__")), bpl::str("::").join(name)));
+  }
+  add_declaration(class_);
+  bpl::object parents = class_.attr("parents");
+  for (long i = 0; i < bpl::len(parents); ++i)
+    visit(parents[i]);
+  bpl::object declarations = class_.attr("declarations");
+  class_.attr("declarations") = bpl::list();
+  push(class_);
+  for (long i = 0; i < bpl::len(declarations); ++i)
+    visit(declarations[i]);
+  pop();
+}
+
+void Linker::visit_typedef(bpl::object typedef_)
+{
+  bpl::object alias = typedef_.attr("alias");
+  bpl::object linked = link_type(alias);
+  if (!is(linked, alias)) typedef_.attr("alias") = linked;
+  add_declaration(typedef_);
+}
+
+void Linker::visit_variable(bpl::object variable)
+{
+  bpl::object vtype = variable.attr("vtype");
+  bpl::object linked = link_type(vtype);
+  if (!is(linked, vtype)) variable.attr("vtype") = linked;
+  add_declaration(variable);
+}
+
+void Linker::visit_const(bpl::object const_)
+{
+  bpl::object ctype = const_.attr("ctype");
+  bpl::object linked = link_type(ctype);
+  if (!is(linked, ctype)) const_.attr("ctype") = linked;
+  add_declaration(const_);
+}
+
+void Linker::visit_function(bpl::object function)
+{
+  Scope &s = top();
+  if (!isinstance(s.scope, class_type_) &&
+      !isinstance(s.scope, class_template_) &&
+      s.functions.has_key(bpl::object(function.attr("name"))))
+    return;
+  bpl::object ret = function.attr("return_type");
+  bpl::object linked = link_type(ret);
+  if (!is(linked, ret)) function.attr("return_type") = linked;
+  bpl::object parameters = function.attr("parameters");
+  for (long i = 0; i < bpl::len(parameters); ++i)
+    visit_parameter(parameters[i]);
+  append(s, function);
+}
+
+void Linker::visit_parameter(bpl::object parameter)
+{
+  bpl::object type = parameter.attr("type");
+  bpl::object linked = link_type(type);
+  if (!is(linked, type)) parameter.attr("type") = linked;
+}
+
+void Linker::visit_inheritance(bpl::object inheritance)
+{
+  bpl::object type = inheritance.attr("parent");
+  if (isinstance(type, declared_type_id_) ||
+      isinstance(type, unknown_type_id_))
+  {
+    bpl::object linked = link_type(type);
+    if (!is(linked, type)) inheritance.attr("parent") = linked;
+  }
+  else if (isinstance(type, parametrized_type_id_))
+  {
+    bpl::object templ = type.attr("template");
+    bpl::object linked = link_type(templ);
+    if (!is(linked, templ))
+    {
+      // The template has to be found through a declared type-id.
+      if (!isinstance(linked, declared_type_id_)) return;
+      bpl::object decl = linked.attr("declaration");
+      if (isinstance(decl, class_template_))
+        type.attr("template") = decl.attr("template");
+    }
+  }
+}
+
+bpl::object link_declarations(bpl::object declarations, bpl::object types)
+{
+  Linker linker(types);
+  return linker.link(declarations);
+}
+
+void link_files(bpl::object files, bpl::object types)
+{
+  Linker linker(types);
+  for (long i = 0; i < bpl::len(files); ++i)
+    linker.link_file(files[i]);
+}
+
+}
+
+BOOST_PYTHON_MODULE(LinkerImpl)
+{
+  bpl::scope scope;
+  scope.attr("version") = "0.1";
+  bpl::class_<Linker, boost::noncopyable>("Linker", bpl::no_init)
+    .def("visit_builtin_type_id", &Linker::visit_builtin_type_id)
+    .def("visit_unknown_type_id", &Linker::visit_unknown_type_id)
+    .def("visit_declared_type_id", &Linker::visit_declared_type_id)
+    .def("visit_template_id", &Linker::visit_template_id)
+    .def("visit_modifier_type_id", &Linker::visit_modifier_type_id)
+    .def("visit_array_type_id", &Linker::visit_array_type_id)
+    .def("visit_parametrized_type_id", &Linker::visit_parametrized_type_id)
+    .def("visit_function_type_id", &Linker::visit_function_type_id)
+    .def("visit_dependent_type_id", &Linker::visit_dependent_type_id)
+    .def("visit_declaration", &Linker::visit_declaration)
+    .def("visit_builtin", &Linker::visit_builtin)
+    .def("visit_using_directive", &Linker::visit_builtin)
+    .def("visit_using_declaration", &Linker::visit_builtin)
+    .def("visit_macro", &Linker::visit_declaration)
+    .def("visit_forward", &Linker::visit_declaration)
+    .def("visit_group", &Linker::visit_group)
+    .def("visit_scope", &Linker::visit_scope)
+    .def("visit_module", &Linker::visit_module)
+    .def("visit_meta_module", &Linker::visit_meta_module)
+    .def("visit_class", &Linker::visit_class)
+    .def("visit_class_template", &Linker::visit_class)
+    .def("visit_typedef", &Linker::visit_typedef)
+    .def("visit_enumerator", &Linker::visit_declaration)
+    .def("visit_enum", &Linker::visit_declaration)
+    .def("visit_variable", &Linker::visit_variable)
+    .def("visit_const", &Linker::visit_const)
+    .def("visit_function", &Linker::visit_function)
+    .def("visit_function_template", &Linker::visit_function)
+    .def("visit_operation", &Linker::visit_function)
+    .def("visit_operation_template", &Linker::visit_function)
+    .def("visit_parameter", &Linker::visit_parameter)
+    .def("visit_inheritance", &Linker::visit_inheritance);
+  bpl::def("link", link_declarations);
+  bpl::def("link_files", link_files);
+}
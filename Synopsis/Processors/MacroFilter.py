@@ -27,8 +27,24 @@ class MacroFilter(Processor, ASG.Visitor):
 
         return self.output_and_return_ir()
 
+    def stage(self, ir):
+
+        return MacroStage(re.compile(self.pattern))
+
     def visit_macro(self, node):
 
         if self._pattern.match(node.name[-1]):
             # Macros always live in the top-most scope.
             self.ir.asg.declarations.remove(node)
+
+class MacroStage(Stage):
+    """Run a MacroFilter in a fused traversal."""
+
+    def __init__(self, pattern):
+
+        self.pattern = pattern
+
+    def enter(self, declaration, scopes):
+
+        return not (isinstance(declaration, ASG.Macro) and
+                    self.pattern.match(declaration.name[-1]))
@@ -5,7 +5,7 @@
 # see the file COPYING for details.
 #
 
-from Synopsis.Processor import Processor, Parameter
+from Synopsis.Processor import Processor, Stage, Parameter
 from Synopsis import ASG
 
 class ModuleFilter(Processor, ASG.Visitor):
@@ -28,6 +28,10 @@ class ModuleFilter(Processor, ASG.Visitor):
 
         return self.output_and_return_ir()
 
+    def stage(self, ir):
+
+        return ModuleFilterStage(self.modules, self.remove_empty)
+
     def push(self):
         """Pushes the current scope onto the stack and starts a new one"""
 
@@ -79,3 +83,33 @@ class ModuleFilter(Processor, ASG.Visitor):
                        0)
         if not self.remove_empty or count: self.pop(module)
         else: self.pop_only()
+
+class ModuleFilterStage(Stage):
+    """Run a ModuleFilter in a fused traversal."""
+
+    def __init__(self, modules, remove_empty):
+
+        self.modules = modules
+        self.remove_empty = remove_empty
+
+    def filtered(self, declaration, scopes):
+        """Return True if the ModuleFilter would see the declaration as a
+        module: it only descends into modules."""
+
+        if not isinstance(declaration, ASG.Module): return False
+        for s in scopes:
+            if not isinstance(s, ASG.Module): return False
+        return True
+
+    def enter(self, declaration, scopes):
+
+        return not (self.filtered(declaration, scopes) and
+                    declaration.name in self.modules)
+
+    def leave(self, declaration, scopes, declarations):
+
+        if not self.remove_empty or not self.filtered(declaration, scopes):
+            return True
+        for d in declarations:
+            if not isinstance(d, (ASG.Forward, ASG.Builtin)): return True
+        return False
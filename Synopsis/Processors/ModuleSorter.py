@@ -5,7 +5,7 @@
 # see the file COPYING for details.
 #
 
-from Synopsis.Processor import Processor, Parameter
+from Synopsis.Processor import Processor, Stage, Parameter
 from Synopsis import ASG
 
 class ModuleSorter(Processor, ASG.Visitor):
@@ -19,11 +19,13 @@ class ModuleSorter(Processor, ASG.Visitor):
         self.__scopestack = []
         self.__currscope = []
 
-        for decl in self.ir.asg.declarations:
-            decl.accept(self)
+        ASG.walk(self, self.ir.asg.declarations)
 
         return self.output_and_return_ir()
 
+    def stage(self, ir):
+
+        return ModuleSorterStage()
 
     def visit_meta_module(self, module):
         """Visits all children of the module, and if there are no declarations
@@ -31,3 +33,16 @@ class ModuleSorter(Processor, ASG.Visitor):
 
         def compare(a, b): return cmp(a.name, b.name)
         module.declarations.sort(compare)
+
+class ModuleSorterStage(Stage):
+    """Run a ModuleSorter in a fused traversal."""
+
+    def leave(self, declaration, scopes, declarations):
+
+        # The ModuleSorter doesn't descend into the modules it sorts.
+        if isinstance(declaration, ASG.MetaModule):
+            for s in scopes:
+                if isinstance(s, ASG.MetaModule): return True
+            def compare(a, b): return cmp(a.name, b.name)
+            declaration.declarations.sort(compare)
+        return True
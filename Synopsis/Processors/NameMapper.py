@@ -46,7 +46,7 @@ class NamePrefixer(NameMapper):
 
         # Now we need to put the declarations in actual nested MetaModules
         for index in range(len(self.prefix), 0, -1):
-            module = ASG.MetaModule(self.type, self.prefix[:index])
+            module = ASG.MetaModule(self.type, tuple(self.prefix[:index]))
             module.declarations.extend(self.ir.asg.declarations)
             self.ir.asg.types[module.name] = ASG.DeclaredTypeId('',
                                                                 module.name,
@@ -66,8 +66,7 @@ class NamePrefixer(NameMapper):
         try:
             type = self.ir.asg.types[name]
             del self.ir.asg.types[name]
-            type.name = new_name
-            self.ir.asg.types[new_name] = type
+            self.ir.asg.types[new_name] = ASG.rename_type_id(type, new_name)
         except KeyError, msg:
             if self.verbose: print "Warning: Unable to map name of type:",msg
 
@@ -5,17 +5,162 @@
 # see the file COPYING for details.
 #
 
-from Synopsis import SXR
+from Synopsis import SXR, SXRFormat
 from Synopsis.Processor import *
 from Synopsis.QualifiedName import *
-from xml.dom.minidom import parse
+from xml.parsers import expat
 import os.path
 
+def read_anchors(filename):
+    """Return the name of the source file the given sxr file was generated
+    from, together with a list of (line, href, from, type) tuples for all
+    its anchors. XML files are parsed in a single streaming pass."""
+
+    if SXRFormat.is_binary(filename):
+        reader = SXRFormat.Reader(filename)
+        return reader.filename(), reader.anchors()
+
+    source = [None]
+    anchors = []
+    line = [0]
+    def start_element(name, attrs):
+        if name == 'line':
+            line[0] += 1
+        elif name == 'a':
+            if attrs.get('continuation') != 'true':
+                anchors.append((line[0], attrs.get('href', ''),
+                                attrs.get('from', ''), attrs.get('type', '')))
+        elif name == 'sxr':
+            source[0] = attrs.get('filename', '')
+    parser = expat.ParserCreate()
+    parser.returns_unicode = False
+    parser.StartElementHandler = start_element
+    input = open(filename, 'rb')
+    try:
+        parser.ParseFile(input)
+    finally:
+        input.close()
+    return source[0], anchors
+
+
+class Compiler(object):
+    """Compiles the anchors of sxr files into `SXR.SXR` symbol tables.
+    Qualified names are interned, so each distinct name is only split
+    (and checked for local scopes) once."""
+
+    def __init__(self, no_locals, verbose = False, debug = False):
+
+        self.no_locals = no_locals
+        self.verbose = verbose
+        self.debug = debug
+        self.names = {}
+        self.scopes = {}
+
+    def qname(self, name, language):
+        """Return the interned name of a symbol, or None if it is local
+        to a function and locals are ignored."""
+
+        names = self.names.setdefault(language, {})
+        try:
+            return names[name]
+        except KeyError:
+            pass
+        if language == 'Python':
+            qname = QualifiedPythonName(name.split('.'))
+        else:
+            qname = QualifiedCxxName(name.split('::'))
+        if self.no_locals:
+            for i in qname:
+                if len(i) > 0 and i[0] == '`':
+                    # Don't store local function variables
+                    qname = None
+                    break
+        names[name] = qname
+        return qname
+
+    def scope(self, name, language):
+        """Return the interned name of a scope."""
+
+        scopes = self.scopes.setdefault(language, {})
+        try:
+            return scopes[name]
+        except KeyError:
+            pass
+        if language == 'Python':
+            origin = QualifiedPythonName(name.split('.'))
+        else:
+            origin = QualifiedCxxName(name.split('::'))
+        if self.no_locals:
+            for i in range(len(origin)):
+                if len(origin[i]) > 0 and origin[i][0] == '`':
+                    # Function scope, truncate here
+                    origin = origin[:i] + (origin[i][1:],)
+                    break
+        scopes[name] = origin
+        return origin
+
+    def compile(self, filename, language, table):
+        """Add the anchors found in 'filename' to 'table'.
+        Return the name of the source file."""
+
+        if self.verbose: print "SXRCompiler: Reading", filename
+        try:
+            source, anchors = read_anchors(filename)
+        except:
+            if self.debug:
+                print 'Error parsing', filename
+                raise
+            else:
+                raise InternalError('parsing %s'%filename)
+        for lineno, href, from_, type in anchors:
+            qname = self.qname(href, language)
+            if qname is None: continue
+            origin = self.scope(from_ or '', language)
+            entry = table.get(qname)
+            if entry is None:
+                entry = table[qname] = SXR.Entry()
+            if type == 'definition':
+                entry.definitions.append((source, lineno, origin))
+            elif type == 'call':
+                entry.calls.append((source, lineno, origin))
+            elif type == 'reference':
+                entry.references.append((source, lineno, origin))
+            else:
+                print 'Warning: Unknown sxr type in %s:%d : %s'%(source, lineno, type)
+        return source
+
+
+def compile_files(args):
+    """Compile the given list of (sxr file, language) pairs. If 'separate'
+    is set, return a (source file, table) pair per file, otherwise return
+    a single table for all of them. This runs inside a worker process
+    of `SXRCompiler`, if more than one job is requested."""
+
+    files, no_locals, separate, verbose, debug = args
+    compiler = Compiler(no_locals, verbose, debug)
+    if separate:
+        result = []
+        for filename, language in files:
+            table = SXR.SXR()
+            source = compiler.compile(filename, language, table)
+            result.append((source, table))
+        return result
+    table = SXR.SXR()
+    for filename, language in files:
+        compiler.compile(filename, language, table)
+    return [(None, table)]
+
+
 class SXRCompiler(Processor):
-    """This class compiles symbol references stored in sxr files into a single symbol table."""
+    """This class compiles symbol references stored in sxr files into a single symbol table.
+    With more than one job, files are compiled in worker processes, each
+    producing a symbol table for its share of the files. These tables are
+    merged in order at the end, so the result doesn't depend on the number
+    of jobs."""
 
     prefix = Parameter('', 'where to look for sxr files')
     no_locals = Parameter(True, '')
+    database = Parameter('', 'SQLite file in which to maintain the compiled symbol table')
 
     def process(self, ir, **kwds):
       
@@ -32,63 +177,42 @@ class SXRCompiler(Processor):
                 filename = os.path.splitdrive(filename)[1][1:]
             return os.path.join(self.prefix, filename) + '.sxr'
 
-        for f in self.ir.files.values():
-            if f.annotations['primary'] and os.path.exists(prefix(f.name)):
-                self.compile(prefix(f.name), f.annotations['language'])
-
-        self.ir.sxr.generate_index()
-
-        return self.ir
-
-    def compile(self, filename, language):
+        self.db = None
+        if self.database:
+            from Synopsis.SXRDatabase import Database
+            self.db = Database(self.database)
 
-        if language == 'Python':
-            QName = lambda name: QualifiedPythonName(str(name).split('.'))
+        files = [(prefix(f.name), f.annotations['language'])
+                 for f in self.ir.files.values()
+                 if f.annotations['primary'] and os.path.exists(prefix(f.name))]
+        # With a database, each file's references are kept separately,
+        # so they can replace the ones stored for it earlier.
+        separate = self.db is not None
+        if self.jobs > 1 and len(files) > 1:
+            import multiprocessing
+            jobs = min(self.jobs, len(files))
+            size = (len(files) + jobs - 1) / jobs
+            chunks = [(files[i:i + size], self.no_locals, separate,
+                       self.verbose, self.debug)
+                      for i in range(0, len(files), size)]
+            pool = multiprocessing.Pool(jobs)
+            try:
+                results = pool.map(compile_files, chunks)
+            finally:
+                pool.close()
+                pool.join()
         else:
-            QName = lambda name: QualifiedCxxName(str(name).split('::'))
+            results = [compile_files((files, self.no_locals, separate,
+                                      self.verbose, self.debug))]
 
+        for result in results:
+            for source, table in result:
+                if self.db:
+                    self.db.remove_file(str(source))
+                    self.db.update(table)
+                self.ir.sxr.merge(table)
 
-        if self.verbose: print "SXRCompiler: Reading", filename
-        try:
-            document = parse(filename)
-        except:
-            if self.debug:
-                print 'Error parsing', filename
-                raise
-            else:
-                raise InternalError('parsing %s'%filename)
-        sxr = document.documentElement
-        filename = sxr.getAttribute('filename')
-        lines = sxr.getElementsByTagName('line')
-        for lineno, line in enumerate(lines):
-            for a in line.getElementsByTagName('a'):
-                if a.getAttribute('continuation') == 'true':
-                    continue
-                qname = QName(a.getAttribute('href'))
-                origin = QName(a.getAttribute('from'))
-                type = str(a.getAttribute('type'))
-                if self.no_locals:
-                    bad = False
-                    for i in range(len(qname)):
-                        if len(qname[i]) > 0 and qname[i][0] == '`':
-                            # Don't store local function variables
-                            bad = True
-                            break
-                    if bad: continue
-  
-                    for i in range(len(origin)):
-                        if len(origin[i]) > 0 and origin[i][0] == '`':
-                            # Function scope, truncate here
-                            origin = origin[:i] + (origin[i][1:],)
-                            break
-                entry = self.ir.sxr.setdefault(qname, SXR.Entry())
-                if type == 'definition':
-                    entry.definitions.append((filename, lineno + 1, origin))
-                elif type == 'call':
-                    entry.calls.append((filename, lineno + 1, origin))
-                elif type == 'reference':
-                    entry.references.append((filename, lineno + 1, origin))
-                else:
-                    print 'Warning: Unknown sxr type in %s:%d : %s'%(filename, lineno + 1, type)
- 
+        if self.db: self.db.close()
+        self.ir.sxr.generate_index()
 
+        return self.ir
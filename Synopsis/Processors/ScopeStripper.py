@@ -67,8 +67,7 @@ class ScopeStripper(Processor, ASG.Visitor):
                 del types[name]
                 name = self.strip_name(name)
                 if name:
-                    type.name = name
-                    types[name] = type
+                    types[name] = ASG.rename_type_id(type, name)
             except:
                 print "ERROR Processing:", name, types[name]
                 raise
@@ -16,8 +16,7 @@ class TypeMapper(Processor, ASG.Visitor):
       self.set_parameters(kwds)
       self.ir = self.merge_input(ir)
 
-      for type in self.ir.asg.types.values():
-         type.accept(self)
+      ASG.walk(self, self.ir.asg.types.values())
 
       return self.output_and_return_ir()
 
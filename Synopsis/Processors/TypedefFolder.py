@@ -22,16 +22,14 @@ class TypedefFolder(Processor, ASG.Visitor):
         # Iterate over a copy so we can safely modify
         # the original in the process.
         decls = ir.asg.declarations[:]
-        for d in decls:
-            d.accept(self)
+        ASG.walk(self, decls)
         return self.output_and_return_ir()
 
     def visit_scope(self, s):
 
         self.scopes.append(s)
         decls = s.declarations[:]
-        for d in decls:
-            d.accept(self)
+        ASG.walk(self, decls)
         self.scopes.pop()
 
     def visit_typedef(self, t):
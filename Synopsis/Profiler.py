@@ -0,0 +1,188 @@
+#
+# Copyright (C) 2011 Stefan Seefeld
+# All rights reserved.
+# Licensed to the public under the terms of the GNU LGPL (>= 2),
+# see the file COPYING for details.
+#
+
+"""A hierarchical profiler.
+
+Code to be profiled is marked as a zone:
+
+  zone = Profiler.zone('name')
+  try:
+      ...
+  finally:
+      zone.end()
+
+Each zone is recorded as an event holding the wall-clock and CPU time spent
+in it, the peak resident set size, and counters incremented by `count()`.
+Zones nest. The native modules record their own zones (see
+src/Support/Profiler.hh), which they `add()` to the zone open in Python.
+`Processor.process` methods are zones, too.
+
+Profiling is enabled by `start()`, and ends with `stop()`, which returns
+the events recorded in between. `summary()` formats them as a flat table,
+and `write_trace()` writes them in the Chrome trace-event format, for
+viewing with chrome://tracing or similar tools.
+Unless profiling is enabled, zones and counters don't do anything."""
+
+import os, time
+
+try:
+    import resource
+    def peak_rss():
+        return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+except ImportError:
+    def peak_rss():
+        return 0
+
+def cpu_time():
+    t = os.times()
+    return t[0] + t[1]
+
+class Event(object):
+    """A profiled zone. Times are measured in microseconds, the peak
+    resident set size in kilobytes."""
+
+    __slots__ = ('name', 'start', 'wall', 'cpu', 'depth', 'rss', 'counters')
+
+    def __init__(self, name, start, wall, cpu, depth, rss, counters):
+
+        self.name = name
+        self.start = start
+        self.wall = wall
+        self.cpu = cpu
+        self.depth = depth
+        self.rss = rss
+        self.counters = counters
+
+class Zone(object):
+    """A zone, open from its creation until end() is called."""
+
+    __slots__ = ('event',)
+
+    def __init__(self, name):
+
+        self.event = event = Event(name, 0, 0, 0, len(_stack), 0, {})
+        _stack.append(event)
+        _events.append(event)
+        event.cpu = cpu_time()
+        event.start = time.time() * 1e6
+
+    def end(self):
+
+        event = self.event
+        event.wall = time.time() * 1e6 - event.start
+        event.cpu = (cpu_time() - event.cpu) * 1e6
+        event.rss = peak_rss()
+        # Zones left open by an exception are closed, too.
+        while _stack and _stack.pop() is not event: pass
+
+class NullZone(object):
+
+    __slots__ = ()
+
+    def end(self): pass
+
+_null_zone = NullZone()
+_enabled = False
+_events = []
+_stack = []
+
+def start():
+    """Enable profiling, discarding any events recorded earlier."""
+
+    global _enabled
+    _enabled = True
+    del _events[:]
+    del _stack[:]
+
+def enabled():
+
+    return _enabled
+
+def stop():
+    """Disable profiling, and return the events recorded."""
+
+    global _enabled
+    _enabled = False
+    events = list(_events)
+    del _events[:]
+    del _stack[:]
+    return events
+
+def zone(name):
+    """Open a zone, to be ended by calling its end() method."""
+
+    return _enabled and Zone(name) or _null_zone
+
+def count(name, n = 1):
+    """Add 'n' to the named counter of the innermost zone."""
+
+    if _enabled and _stack:
+        counters = _stack[-1].counters
+        counters[name] = counters.get(name, 0) + n
+
+def add(events):
+    """Add events recorded elsewhere (notably by native modules) as
+    (name, start, wall, cpu, depth, rss, counters) tuples, nested
+    inside the innermost zone."""
+
+    if not _enabled: return
+    depth = len(_stack)
+    for name, start, wall, cpu, d, rss, counters in events:
+        _events.append(Event(name, start, wall, cpu, depth + d, rss, dict(counters)))
+
+def summary(events):
+    """Return a flat summary of the given events: the number of calls, the
+    total wall-clock and CPU time, and the peak resident set size per
+    zone, as well as the total of each counter."""
+
+    zones = {}
+    order = []
+    for e in events:
+        z = zones.get(e.name)
+        if z is None:
+            z = zones[e.name] = [0, 0., 0., 0, {}]
+            order.append(e.name)
+        z[0] += 1
+        z[1] += e.wall
+        z[2] += e.cpu
+        z[3] = max(z[3], e.rss)
+        for c, n in e.counters.items():
+            z[4][c] = z[4].get(c, 0) + n
+
+    if not order: return ''
+    width = max([len(name) for name in order])
+    lines = ['%-*s %8s %10s %10s %10s'%(width, 'zone', 'calls', 'wall (s)',
+                                        'cpu (s)', 'rss (kB)')]
+    for name in order:
+        calls, wall, cpu, rss, counters = zones[name]
+        lines.append('%-*s %8d %10.3f %10.3f %10d'%(width, name, calls,
+                                                    wall / 1e6, cpu / 1e6, rss))
+        for c in sorted(counters):
+            lines.append('%-*s   %s: %d'%(width, '', c, counters[c]))
+    return '\n'.join(lines)
+
+def write_trace(filename, events):
+    """Write the given events to 'filename', in the Chrome trace-event format."""
+
+    try:
+        import json
+    except ImportError:
+        # 2.5 compatibility
+        import simplejson as json
+    pid = os.getpid()
+    trace = []
+    for e in events:
+        args = dict(e.counters)
+        args['cpu_us'] = e.cpu
+        args['rss_kb'] = e.rss
+        trace.append({'name': e.name, 'ph': 'X', 'ts': e.start, 'dur': e.wall,
+                      'pid': pid, 'tid': 0, 'args': args})
+    file = open(filename, 'w')
+    try:
+        json.dump({'traceEvents': trace, 'displayTimeUnit': 'ms'}, file)
+    finally:
+        file.close()
@@ -5,10 +5,46 @@
 # see the file COPYING for details.
 #
 
+_interned = {}
+"""Map each QualifiedName type to a dictionary holding its instances."""
+
+def reset():
+    """Forget all interned names, so the ones no longer in use can be
+    freed. (Names are tuples, which can't be weakly referenced.) Names
+    created afterwards are equal to, but distinct from, earlier ones.
+    Long-running processes may call this between unrelated IRs."""
+
+    _interned.clear()
+
 class QualifiedName(tuple):
+    """A name qualified by the names of its enclosing scopes.
+
+    Qualified names are interned: constructing a name equal to an existing
+    one of the same type returns the existing one. As the same names are
+    used throughout the IR, by declarations, type-ids and cross-references
+    alike, this keeps a single copy of each around, in memory as well as in
+    pickled IRs."""
 
     sep = ''
 
+    def __new__(cls, components = ()):
+
+        table = _interned.get(cls)
+        if table is None:
+            table = _interned[cls] = {}
+        components = tuple(components)
+        name = table.get(components)
+        if name is None:
+            name = tuple.__new__(cls, [type(c) is str and intern(c) or c
+                                       for c in components])
+            table[name] = name
+        return name
+
+    def __reduce__(self):
+        """Make sure unpickled names are interned, too."""
+
+        return type(self), (tuple(self),)
+
     def __getitem__(self, i):
         """If i is a slice, make sure a QualifiedName is returned."""
         
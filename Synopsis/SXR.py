@@ -5,34 +5,271 @@
 # see the file COPYING for details.
 #
 
-class Entry(object):
+"""Symbol cross-references.
+
+References are stored in columns: file ids, line numbers and scope ids
+are kept in packed integer arrays, and file names and scopes only once,
+in a `Table`. `References` exposes those columns as a sequence of
+(file, line, scope) tuples, which are created as they are accessed."""
+
+from array import array
+from itertools import izip
+import sys
+
+def _pack(columns):
+    """Return the bytes of an array of ints, little-endian, so pickles
+    can be read on machines of either byte order."""
+
+    if sys.byteorder == 'big':
+        columns = array('i', columns)
+        columns.byteswap()
+    return columns.tostring()
+
+def _unpack(data):
+    """Return the array of ints packed into 'data' by `_pack`."""
+
+    columns = array('i', data)
+    if sys.byteorder == 'big': columns.byteswap()
+    return columns
+
+class Table(object):
+    """Maps file names and scopes to ids, and back."""
 
     def __init__(self):
+
+        self.files = []
+        "List of file names, indexed by id."
+        self.scopes = []
+        "List of scopes, indexed by id."
+        self._file_ids = {}
+        self._scope_ids = {}
+        self._ranks = None
+        self._mapping = None
+
+    def file_id(self, file):
+
+        id = self._file_ids.get(file)
+        if id is None:
+            id = self._file_ids[file] = len(self.files)
+            self.files.append(file)
+        return id
+
+    def scope_id(self, scope):
+
+        id = self._scope_ids.get(scope)
+        if id is None:
+            id = self._scope_ids[scope] = len(self.scopes)
+            self.scopes.append(scope)
+        return id
+
+    def ranks(self):
+        """Return the positions of the file names and of the scopes in
+        sorted order, as arrays indexed by id."""
+
+        size = len(self.files), len(self.scopes)
+        if self._ranks is None or self._ranks[0] != size:
+            self._ranks = size, _ranks(self.files), _ranks(self.scopes)
+        return self._ranks[1], self._ranks[2]
+
+    def mapping(self, other):
+        """Return the ids the file names and scopes of table 'other' have
+        in this one, as two lists indexed by the ids in 'other'. The last
+        mapping is cached, as merges look up the same table repeatedly."""
+
+        if self._mapping is None or self._mapping[0] is not other:
+            self._mapping = other, [], []
+        other, files, scopes = self._mapping
+        for f in other.files[len(files):]: files.append(self.file_id(f))
+        for s in other.scopes[len(scopes):]: scopes.append(self.scope_id(s))
+        return files, scopes
+
+    def __getstate__(self):
+
+        return self.files, self.scopes
+
+    def __setstate__(self, state):
+
+        self.__init__()
+        for f in state[0]: self.file_id(f)
+        for s in state[1]: self.scope_id(s)
+
+
+def _ranks(values):
+
+    order = range(len(values))
+    order.sort(key=values.__getitem__)
+    ranks = array('i', order)
+    for rank, id in enumerate(order):
+        ranks[id] = rank
+    return ranks
+
+_table = Table()
+"The table used by default, shared by all entries created in this process."
+
+
+class References(object):
+    """A sequence of (file, line, scope) tuples, stored as arrays of file
+    ids, line numbers and scope ids into a `Table`."""
+
+    __slots__ = ('table', 'files', 'lines', 'scopes')
+
+    def __init__(self, table = None):
+
+        self.table = table or _table
+        self.files = array('i')
+        self.lines = array('i')
+        self.scopes = array('i')
+
+    def __len__(self):
+
+        return len(self.lines)
+
+    def __getitem__(self, i):
+
+        if isinstance(i, slice):
+            return [self[j] for j in range(*i.indices(len(self)))]
+        return (self.table.files[self.files[i]],
+                self.lines[i],
+                self.table.scopes[self.scopes[i]])
+
+    def __iter__(self):
+
+        files, scopes = self.table.files, self.table.scopes
+        for f, l, s in izip(self.files, self.lines, self.scopes):
+            yield files[f], l, scopes[s]
+
+    def __eq__(self, other):
+
+        return list(self) == list(other)
+
+    def __ne__(self, other):
+
+        return not self == other
+
+    def __repr__(self):
+
+        return repr(list(self))
+
+    def append(self, reference):
+
+        file, line, scope = reference
+        self.files.append(self.table.file_id(file))
+        self.lines.append(line)
+        self.scopes.append(self.table.scope_id(scope))
+
+    def extend(self, references):
+
+        if not isinstance(references, References):
+            for r in references: self.append(r)
+        elif references.table is self.table:
+            self.files.extend(references.files)
+            self.lines.extend(references.lines)
+            self.scopes.extend(references.scopes)
+        else:
+            files, scopes = self.table.mapping(references.table)
+            self.files.extend(array('i', [files[f] for f in references.files]))
+            self.lines.extend(references.lines)
+            self.scopes.extend(array('i', [scopes[s] for s in references.scopes]))
+
+    def __iadd__(self, references):
+
+        self.extend(references)
+        return self
+
+    def sort(self):
+        """Sort by file, line, and scope, as a list of tuples would be.
+        Each reference is ranked by a single integer key."""
+
+        if len(self) < 2: return
+        file_ranks, scope_ranks = self.table.ranks()
+        lines = max(self.lines) + 1
+        scopes = len(scope_ranks)
+        keys = [(file_ranks[f] * lines + l) * scopes + scope_ranks[s]
+                for f, l, s in izip(self.files, self.lines, self.scopes)]
+        order = range(len(keys))
+        order.sort(key=keys.__getitem__)
+        self.files = array('i', [self.files[i] for i in order])
+        self.lines = array('i', [self.lines[i] for i in order])
+        self.scopes = array('i', [self.scopes[i] for i in order])
+
+    def __getstate__(self):
+
+        if not self.lines: return (self.table,)
+        return self.table, _pack(self.files + self.lines + self.scopes)
+
+    def __setstate__(self, state):
+
+        self.table = state[0]
+        columns = _unpack(len(state) > 1 and state[1] or '')
+        size = len(columns) // 3
+        self.files = columns[:size]
+        self.lines = columns[size:2 * size]
+        self.scopes = columns[2 * size:]
+
+class Entry(object):
+
+    def __init__(self, table = None):
         """Represents a set of references found for a given symbol."""
 
-        self.definitions = []
-        "List of (file, line, scope) tuples."
-        self.calls = []
-        "List of (file, line, scope) tuples."
-        self.references = []
-        "List of (file, line, scope) tuples."
+        table = table or _table
+        self.definitions = References(table)
+        "Sequence of (file, line, scope) tuples."
+        self.calls = References(table)
+        "Sequence of (file, line, scope) tuples."
+        self.references = References(table)
+        "Sequence of (file, line, scope) tuples."
+
+    def __getstate__(self):
+        """Pickle the columns of all three sequences as a single string."""
+
+        kinds = self.definitions, self.calls, self.references
+        table = getattr(self.definitions, 'table', None)
+        if table is None or [k for k in kinds if getattr(k, 'table', None) is not table]:
+            return self.__dict__
+        columns = array('i')
+        for k in kinds:
+            columns += k.files + k.lines + k.scopes
+        return table, tuple([len(k) for k in kinds]), _pack(columns)
+
+    def __setstate__(self, state):
+
+        if isinstance(state, dict):
+            # Entries pickled with lists, or with sequences in several tables.
+            self.__dict__.update(state)
+            return
+        table, sizes, data = state
+        columns = _unpack(data)
+        start = 0
+        for kind, size in zip(('definitions', 'calls', 'references'), sizes):
+            k = References(table)
+            k.files = columns[start:start + size]
+            k.lines = columns[start + size:start + 2 * size]
+            k.scopes = columns[start + 2 * size:start + 3 * size]
+            start += 3 * size
+            setattr(self, kind, k)
 
 
 class SXR(dict):
     """Symboltable containing source code locations of symbol definitions,
     as well as different types of references."""
 
+    _dirty = False
+    "True if entries were merged in since the index was last generated."
+
     def __init__(self):
 
         self._index = {}
 
     def index(self):
 
+        if self._dirty:
+            self.generate_index()
         return self._index
     
     def generate_index(self):
         """(Re-)generate an index after entries have been added."""
 
+        self._index = {}
         # Sort the data
         for target, entry in self.items():
             entry.calls.sort()
@@ -44,8 +281,12 @@ class SXR(dict):
             paren = name.find('(')
             if paren != -1:
                 self._index.setdefault(name[:paren],[]).append(target)
+        self._dirty = False
 
     def merge(self, other):
+        """Merge the entries of another SXR into this one. The index is
+        only regenerated on the next call to `index()`, so merging many
+        symbol tables in a row stays linear."""
 
         for k in other:
             e = other[k]
@@ -55,5 +296,4 @@ class SXR(dict):
             entry.calls += e.calls
             entry.references += e.references
 
-        self.generate_index()
-
+        if other: self._dirty = True
@@ -0,0 +1,231 @@
+#
+# Copyright (C) 2011 Stefan Seefeld
+# All rights reserved.
+# Licensed to the public under the terms of the GNU LGPL (>= 2),
+# see the file COPYING for details.
+#
+
+"""Persistent store for the Source Cross-Reference symbol table.
+
+Instead of holding all references in a pickled `SXR.SXR` dictionary, the
+database keeps them in an SQLite file, with one row per (symbol, kind,
+file, line, scope) reference. Inserting a reference twice has no effect,
+the lookup indexes are maintained by SQLite as rows are added or removed,
+and queries return (pages of) results without loading the whole table."""
+
+from Synopsis.QualifiedName import *
+from Synopsis import SXR
+import sqlite3
+
+_schema = """
+CREATE TABLE IF NOT EXISTS symbol (
+  id INTEGER PRIMARY KEY,
+  name TEXT UNIQUE NOT NULL,
+  language TEXT NOT NULL,
+  last TEXT NOT NULL,
+  base TEXT NOT NULL);
+CREATE INDEX IF NOT EXISTS symbol_last ON symbol (last);
+CREATE INDEX IF NOT EXISTS symbol_base ON symbol (base);
+CREATE TABLE IF NOT EXISTS file (
+  id INTEGER PRIMARY KEY,
+  name TEXT UNIQUE NOT NULL);
+CREATE TABLE IF NOT EXISTS reference (
+  symbol INTEGER NOT NULL REFERENCES symbol (id),
+  kind INTEGER NOT NULL,
+  file INTEGER NOT NULL REFERENCES file (id),
+  line INTEGER NOT NULL,
+  scope INTEGER NOT NULL REFERENCES symbol (id),
+  UNIQUE (symbol, kind, file, line, scope));
+CREATE INDEX IF NOT EXISTS reference_file ON reference (file);
+"""
+
+DEFINITION, CALL, REFERENCE = 0, 1, 2
+"""Reference kinds, in the order used by `SXR.Entry`."""
+
+_kinds = ('definitions', 'calls', 'references')
+
+# Components are joined with a character that can't be part of an identifier,
+# so names round-trip exactly.
+_sep = '\x1f'
+_languages = {QualifiedCxxName: 'C++', QualifiedPythonName: 'Python'}
+_types = {'C++': QualifiedCxxName, 'Python': QualifiedPythonName}
+
+
+class Index(object):
+    """Map from (unqualified) symbol names to the list of qualified names
+    ending in them, mimicking the dictionary returned by `SXR.SXR.index()`."""
+
+    def __init__(self, database):
+
+        self._database = database
+
+    def has_key(self, name):
+
+        return bool(self._database.search(name, limit = 1))
+
+    __contains__ = has_key
+
+    def __getitem__(self, name):
+
+        matches = self._database.search(name)
+        if not matches: raise KeyError(name)
+        return matches
+
+    def get(self, name, default = None):
+
+        return self._database.search(name) or default
+
+
+class Database(object):
+    """An SQLite-backed symbol table. Provides the read-only dictionary
+    interface of `SXR.SXR`, so it can be queried in its place."""
+
+    def __init__(self, filename, check_same_thread = True):
+        """Open (or create) the database in 'filename'. A database shared
+        between threads needs 'check_same_thread' to be False, and its
+        users need to serialize access themselves."""
+
+        self.filename = filename
+        self._db = sqlite3.connect(filename, check_same_thread = check_same_thread)
+        self._db.text_factory = str
+        self._db.executescript(_schema)
+        self._symbols = {}
+        self._files = {}
+
+    def close(self):
+
+        self._db.commit()
+        self._db.close()
+
+    def commit(self):
+
+        self._db.commit()
+
+    def _encode(self, name):
+
+        return _sep.join(name)
+
+    def _decode(self, name, language):
+
+        # The global scope is stored as an empty string, which split()
+        # would turn into a single empty component.
+        components = name and name.split(_sep) or []
+        return _types.get(language, QualifiedName)(components)
+
+    def _symbol(self, name):
+        """Return the id of the given symbol, inserting it if necessary."""
+
+        key = self._encode(name)
+        id = self._symbols.get(key)
+        if id is None:
+            cursor = self._db.execute('SELECT id FROM symbol WHERE name = ?', (key,))
+            row = cursor.fetchone()
+            if row:
+                id = row[0]
+            else:
+                last = len(name) and name[-1] or ''
+                paren = last.find('(')
+                base = paren != -1 and last[:paren] or last
+                cursor = self._db.execute('INSERT INTO symbol (name, language, last, base) '
+                                          'VALUES (?, ?, ?, ?)',
+                                          (key, _languages.get(type(name), ''),
+                                           last, base))
+                id = cursor.lastrowid
+            self._symbols[key] = id
+        return id
+
+    def _file(self, name):
+        """Return the id of the given file, inserting it if necessary."""
+
+        id = self._files.get(name)
+        if id is None:
+            cursor = self._db.execute('SELECT id FROM file WHERE name = ?', (name,))
+            row = cursor.fetchone()
+            if row:
+                id = row[0]
+            else:
+                id = self._db.execute('INSERT INTO file (name) VALUES (?)',
+                                      (name,)).lastrowid
+            self._files[name] = id
+        return id
+
+    def insert(self, name, kind, file, line, scope):
+        """Add a single reference. Duplicates are ignored."""
+
+        self._db.execute('INSERT OR IGNORE INTO reference VALUES (?, ?, ?, ?, ?)',
+                         (self._symbol(name), kind, self._file(file), line,
+                          self._symbol(scope)))
+
+    def update(self, sxr):
+        """Add all references from the given `SXR.SXR` symbol table."""
+
+        rows = []
+        for name, entry in sxr.iteritems():
+            symbol = self._symbol(name)
+            for kind, attribute in enumerate(_kinds):
+                for file, line, scope in getattr(entry, attribute):
+                    rows.append((symbol, kind, self._file(file), line,
+                                 self._symbol(scope)))
+        self._db.executemany('INSERT OR IGNORE INTO reference VALUES (?, ?, ?, ?, ?)',
+                             rows)
+
+    def remove_file(self, file):
+        """Remove all references found in the given file, such as before
+        recompiling its cross-references."""
+
+        self._db.execute('DELETE FROM reference WHERE file = '
+                         '(SELECT id FROM file WHERE name = ?)', (file,))
+
+    def has_key(self, name):
+
+        return bool(self._db.execute('SELECT 1 FROM symbol s, reference r '
+                                     'WHERE s.name = ? AND r.symbol = s.id LIMIT 1',
+                                     (self._encode(name),)).fetchone())
+
+    __contains__ = has_key
+
+    def __getitem__(self, name):
+
+        entry = self.get(name)
+        if entry is None: raise KeyError(name)
+        return entry
+
+    def get(self, name, default = None):
+        """Return the `SXR.Entry` for the given symbol."""
+
+        cursor = self._db.execute('SELECT r.kind, f.name, r.line, s.name, s.language '
+                                  'FROM reference r, file f, symbol s '
+                                  'WHERE r.symbol = (SELECT id FROM symbol WHERE name = ?) '
+                                  'AND f.id = r.file AND s.id = r.scope '
+                                  'ORDER BY r.kind, f.name, r.line',
+                                  (self._encode(name),))
+        entry = None
+        for kind, file, line, scope, language in cursor:
+            if entry is None: entry = SXR.Entry()
+            getattr(entry, _kinds[kind]).append((file, line,
+                                                 self._decode(scope, language)))
+        return entry or default
+
+    def keys(self, offset = 0, limit = -1):
+        """Return (a page of) the sorted list of symbols with references."""
+
+        cursor = self._db.execute('SELECT name, language FROM symbol WHERE id IN '
+                                  '(SELECT DISTINCT symbol FROM reference) '
+                                  'ORDER BY name LIMIT ? OFFSET ?', (limit, offset))
+        return [self._decode(n, l) for n, l in cursor]
+
+    def search(self, name, offset = 0, limit = -1):
+        """Return (a page of) the symbols whose last component is 'name',
+        with or without a parameter list."""
+
+        cursor = self._db.execute('SELECT name, language FROM symbol '
+                                  'WHERE (last = ? OR base = ?) AND id IN '
+                                  '(SELECT symbol FROM reference) '
+                                  'ORDER BY name LIMIT ? OFFSET ?',
+                                  (name, name, limit, offset))
+        return [self._decode(n, l) for n, l in cursor]
+
+    def index(self):
+        """Return an index object compatible with `SXR.SXR.index()`."""
+
+        return Index(self)
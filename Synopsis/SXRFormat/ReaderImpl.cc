@@ -0,0 +1,152 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#include <Support/SXR.hh>
+#include <boost/python.hpp>
+#include <vector>
+
+using namespace Synopsis;
+namespace bpl = boost::python;
+
+namespace
+{
+
+//. Convert the reader's string table once, so equal strings map to the
+//. same Python object.
+std::vector<bpl::object> strings(SXR::Reader const &r, std::vector<unsigned> const &ids)
+{
+  std::vector<bpl::object> objects;
+  unsigned max = 0;
+  for (std::vector<unsigned>::const_iterator i = ids.begin(); i != ids.end(); ++i)
+    if (*i != SXR::Binary::NONE && *i >= max) max = *i + 1;
+  objects.resize(max);
+  for (std::vector<unsigned>::const_iterator i = ids.begin(); i != ids.end(); ++i)
+    if (*i != SXR::Binary::NONE && objects[*i].ptr() == Py_None)
+      objects[*i] = bpl::str(r.string(*i));
+  return objects;
+}
+
+bpl::object string(std::vector<bpl::object> const &objects, unsigned i)
+{
+  return i == SXR::Binary::NONE ? bpl::object() : objects[i];
+}
+
+//. Return the line's text and its spans, as (column, length, flags, a, b, c)
+//. tuples.
+bpl::tuple line(SXR::Reader const &r, size_t i)
+{
+  if (i >= r.lines())
+  {
+    PyErr_SetString(PyExc_IndexError, "line index out of range");
+    bpl::throw_error_already_set();
+  }
+  SXR::Reader::Line const &l = r.line(i);
+  std::vector<unsigned> ids;
+  for (unsigned j = l.first_span; j != l.first_span + l.spans; ++j)
+  {
+    SXR::Reader::Span const &s = r.span(j);
+    ids.push_back(s.a);
+    ids.push_back(s.b);
+    ids.push_back(s.c);
+  }
+  std::vector<bpl::object> objects = strings(r, ids);
+  bpl::list spans;
+  for (unsigned j = l.first_span; j != l.first_span + l.spans; ++j)
+  {
+    SXR::Reader::Span const &s = r.span(j);
+    spans.append(bpl::make_tuple(s.column, s.length, s.flags,
+                                 string(objects, s.a),
+                                 string(objects, s.b),
+                                 string(objects, s.c)));
+  }
+  return bpl::make_tuple(r.text(l), spans);
+}
+
+//. Return all anchors as (line, href, from, type) tuples, with line
+//. numbers starting at 1.
+bpl::list anchors(SXR::Reader const &r)
+{
+  std::vector<unsigned> ids;
+  for (size_t i = 0; i != r.lines(); ++i)
+  {
+    SXR::Reader::Line const &l = r.line(i);
+    for (unsigned j = l.first_span; j != l.first_span + l.spans; ++j)
+    {
+      SXR::Reader::Span const &s = r.span(j);
+      if (!s.is_anchor()) continue;
+      ids.push_back(s.a);
+      ids.push_back(s.b);
+      ids.push_back(s.c);
+    }
+  }
+  std::vector<bpl::object> objects = strings(r, ids);
+  bpl::list result;
+  for (size_t i = 0; i != r.lines(); ++i)
+  {
+    SXR::Reader::Line const &l = r.line(i);
+    for (unsigned j = l.first_span; j != l.first_span + l.spans; ++j)
+    {
+      SXR::Reader::Span const &s = r.span(j);
+      if (!s.is_anchor()) continue;
+      result.append(bpl::make_tuple(i + 1,
+                                    string(objects, s.a),
+                                    string(objects, s.b),
+                                    string(objects, s.c)));
+    }
+  }
+  return result;
+}
+
+//. The XML writer, with the interface of SXRFormat.XMLWriter.
+class XMLWriter : boost::noncopyable
+{
+public:
+  XMLWriter(std::string const &sxr, std::string const &filename)
+    : writer_(sxr, filename) {}
+
+  void text(std::string const &t) { writer_.text(t.data(), t.size());}
+  void space(size_t n) { writer_.space(n);}
+  void span(std::string const &cls, std::string const &t, bool continuation)
+  { writer_.span(cls.c_str(), t.data(), t.size(), continuation);}
+  void anchor(std::string const &href, bpl::object from,
+              std::string const &type, std::string const &t)
+  {
+    std::string f;
+    if (from) f = bpl::extract<std::string>(from);
+    writer_.anchor(href, f, type.c_str(), t.data(), t.size());
+  }
+  void newline() { writer_.newline();}
+  void close() { writer_.close();}
+
+private:
+  SXR::XMLWriter writer_;
+};
+
+}
+
+BOOST_PYTHON_MODULE(ReaderImpl)
+{
+  bpl::scope scope;
+  scope.attr("version") = "0.1";
+  bpl::def("is_binary", &SXR::Reader::is_binary);
+  bpl::class_<SXR::Reader, boost::noncopyable>("Reader", bpl::init<std::string>())
+    .def("filename", &SXR::Reader::filename,
+         bpl::return_value_policy<bpl::copy_const_reference>())
+    .def("lines", &SXR::Reader::lines)
+    .def("line", line)
+    .def("anchors", anchors)
+    .def("write_xml", &SXR::Reader::write_xml);
+  bpl::class_<XMLWriter, boost::noncopyable>("XMLWriter",
+                                             bpl::init<std::string, std::string>())
+    .def("text", &XMLWriter::text)
+    .def("space", &XMLWriter::space)
+    .def("span", &XMLWriter::span,
+         (bpl::arg("class_"), bpl::arg("text"), bpl::arg("continuation") = false))
+    .def("anchor", &XMLWriter::anchor)
+    .def("newline", &XMLWriter::newline)
+    .def("close", &XMLWriter::close);
+}
@@ -0,0 +1,312 @@
+#
+# Copyright (C) 2011 Stefan Seefeld
+# All rights reserved.
+# Licensed to the public under the terms of the GNU LGPL (>= 2),
+# see the file COPYING for details.
+#
+
+"""Reading and writing of sxr files.
+
+Besides the traditional XML format, sxr files may be written in a compact
+binary format, consisting of a line table, a table of highlighted spans and
+cross-reference anchors, and a table of interned strings (see
+src/Support/SXR.hh for the layout). Both formats use the same '.sxr'
+extension, as they are told apart by their content.
+
+The binary format is read, and the XML format written, by the `ReaderImpl`
+extension module if it was built, and by a pure-Python implementation
+otherwise."""
+
+import struct, zlib
+
+MAGIC = 'SXB\1'
+COMPRESSED = 1
+ANCHOR, CONTINUATION = 1, 2
+NONE = 0xffffffff
+MAX_RATIO = 1032
+
+def escape(text):
+
+    for p in [('&', '&amp;'), ('"', '&quot;'), ('<', '&lt;'), ('>', '&gt;'),]:
+        text = text.replace(*p)
+    return text
+
+
+class XMLWriter:
+    """Writes the XML sxr format."""
+
+    def __init__(self, sxr, filename):
+
+        self.output = open(sxr, 'w+')
+        self.output.write('<sxr filename="%s">\n<line>'%escape(filename))
+
+    def text(self, text):
+
+        self.output.write(escape(text))
+
+    def space(self, n):
+
+        self.output.write(' ' * n)
+
+    def span(self, class_, text, continuation = False):
+
+        if continuation:
+            self.output.write('<span class="%s" continuation="true">%s</span>'
+                              %(class_, escape(text)))
+        else:
+            self.output.write('<span class="%s">%s</span>'%(class_, escape(text)))
+
+    def anchor(self, href, from_, type, text):
+
+        if from_:
+            self.output.write('<a href="%s" from="%s" type="%s">%s</a>'
+                              %(escape(href), escape(from_), type, escape(text)))
+        else:
+            self.output.write('<a href="%s" type="%s">%s</a>'
+                              %(escape(href), type, escape(text)))
+
+    def newline(self):
+
+        self.output.write('</line>\n<line>')
+
+    def close(self):
+
+        self.output.write('</line>\n</sxr>\n')
+        self.output.close()
+
+
+class BinaryWriter:
+    """Writes the binary sxr format, optionally compressed."""
+
+    def __init__(self, sxr, filename, compress = False):
+
+        self.sxr = sxr
+        self.compress = compress
+        self.strings = []
+        self.ids = {}
+        self.lines = []
+        self.spans = []
+        self.chunks = []
+        self.size = 0
+        self.line_start = 0
+        self.filename = self.intern(filename)
+
+    def intern(self, string):
+
+        id = self.ids.get(string)
+        if id is None:
+            id = self.ids[string] = len(self.strings)
+            self.strings.append(string)
+        return id
+
+    def append(self, text):
+
+        self.chunks.append(text)
+        self.size += len(text)
+
+    def text(self, text):
+
+        self.append(text)
+
+    def space(self, n):
+
+        self.append(' ' * n)
+
+    def span(self, class_, text, continuation = False):
+
+        self.spans.append((self.size - self.line_start, len(text),
+                           continuation and CONTINUATION or 0,
+                           self.intern(class_), NONE, NONE))
+        self.append(text)
+
+    def anchor(self, href, from_, type, text):
+
+        self.spans.append((self.size - self.line_start, len(text), ANCHOR,
+                           self.intern(href),
+                           self.intern(from_) if from_ else NONE,
+                           self.intern(type)))
+        self.append(text)
+
+    def newline(self):
+
+        if self.lines: first = self.lines[-1][2] + self.lines[-1][3]
+        else: first = 0
+        self.lines.append((self.line_start, self.size - self.line_start,
+                           first, len(self.spans) - first))
+        self.line_start = self.size
+
+    def close(self):
+
+        self.newline()
+        payload = [struct.pack('<5I', self.filename, len(self.strings),
+                               len(self.lines), len(self.spans), self.size)]
+        for s in self.strings:
+            payload.append(struct.pack('<I', len(s)))
+            payload.append(s)
+        payload.extend([struct.pack('<4I', *l) for l in self.lines])
+        payload.extend([struct.pack('<6I', *s) for s in self.spans])
+        payload.extend(self.chunks)
+        payload = ''.join(payload)
+        flags = self.compress and COMPRESSED or 0
+        header = MAGIC + struct.pack('<2I', flags, len(payload))
+        if self.compress:
+            payload = zlib.compress(payload)
+        output = open(self.sxr, 'wb')
+        output.write(header)
+        output.write(payload)
+        output.close()
+
+
+def make_writer(format, sxr, filename):
+    """Create a writer for the given format ('xml', 'binary', or 'compressed')."""
+
+    if format in ('', 'xml'): return XMLWriter(sxr, filename)
+    elif format == 'binary': return BinaryWriter(sxr, filename)
+    elif format == 'compressed': return BinaryWriter(sxr, filename, True)
+    else: raise ValueError('unknown sxr format: %s'%format)
+
+
+def is_binary(sxr):
+    """Return True if the given file is in the binary sxr format."""
+
+    input = open(sxr, 'rb')
+    magic = input.read(4)
+    input.close()
+    return magic == MAGIC
+
+
+class Reader:
+    """Reads a binary sxr file into memory."""
+
+    def __init__(self, sxr):
+
+        data = open(sxr, 'rb').read()
+        if len(data) < 12 or data[:4] != MAGIC:
+            raise RuntimeError('%s is not a binary sxr file'%sxr)
+        flags, size = struct.unpack_from('<2I', data, 4)
+        payload = data[12:]
+        if flags & COMPRESSED:
+            # deflate can't compress better than about 1032:1, so a larger
+            # payload size in the header means the file is corrupt.
+            if size / MAX_RATIO > len(payload):
+                raise RuntimeError('corrupt sxr file')
+            try:
+                payload = zlib.decompressobj().decompress(payload, size + 1)
+            except zlib.error:
+                payload = None
+            if payload is None or len(payload) != size:
+                raise RuntimeError('unable to uncompress %s'%sxr)
+        try:
+            self._read(payload)
+        except struct.error:
+            raise RuntimeError('truncated sxr file')
+        self._validate()
+        self._filename = self._strings[self._filename]
+
+    def _read(self, payload):
+
+        filename, strings, lines, spans, text = struct.unpack_from('<5I', payload)
+        offset = 20
+        # Strings take at least 4 bytes each, lines 16, and spans 24.
+        left = len(payload) - offset
+        if left / 4 < strings or left / 16 < lines or left / 24 < spans:
+            raise RuntimeError('truncated sxr file')
+        self._filename = filename
+        self._strings = []
+        for i in xrange(strings):
+            length, = struct.unpack_from('<I', payload, offset)
+            offset += 4
+            if len(payload) - offset < length:
+                raise RuntimeError('truncated sxr file')
+            self._strings.append(payload[offset:offset + length])
+            offset += length
+        self._lines = [struct.unpack_from('<4I', payload, offset + 16 * i)
+                       for i in xrange(lines)]
+        offset += 16 * lines
+        self._spans = [struct.unpack_from('<6I', payload, offset + 24 * i)
+                       for i in xrange(spans)]
+        offset += 24 * spans
+        self._text = payload[offset:]
+        if len(self._text) != text:
+            raise RuntimeError('truncated sxr file')
+
+    def _validate(self):
+        """Make sure all lines lie within the text, all spans within their
+        line, in order, and that all string ids are valid, as the C++
+        reader does."""
+
+        strings = len(self._strings)
+        def valid(i, optional):
+            return i < strings or (optional and i == NONE)
+
+        if not valid(self._filename, False):
+            raise RuntimeError('corrupt sxr file')
+        text, spans = len(self._text), len(self._spans)
+        for offset, length, first, count in self._lines:
+            if (offset > text or length > text - offset or
+                first > spans or count > spans - first):
+                raise RuntimeError('corrupt sxr file')
+            column = 0
+            for c, l, f, a, b, c_ in self._spans[first:first + count]:
+                if (c < column or c > length or l > length - c or
+                    not valid(a, False) or not valid(b, True) or
+                    not valid(c_, not (f & ANCHOR))):
+                    raise RuntimeError('corrupt sxr file')
+                column = c + l
+
+    def _string(self, i):
+
+        return self._strings[i] if i != NONE else None
+
+    def filename(self):
+
+        return self._filename
+
+    def lines(self):
+
+        return len(self._lines)
+
+    def line(self, i):
+        """Return the line's text and its spans, as
+        (column, length, flags, a, b, c) tuples."""
+
+        offset, length, first, count = self._lines[i]
+        return (self._text[offset:offset + length],
+                [(c, l, f, self._string(a), self._string(b), self._string(c_))
+                 for c, l, f, a, b, c_ in self._spans[first:first + count]])
+
+    def anchors(self):
+        """Return all anchors as (line, href, from, type) tuples, with line
+        numbers starting at 1."""
+
+        result = []
+        for lineno, (offset, length, first, count) in enumerate(self._lines):
+            for c, l, f, a, b, c_ in self._spans[first:first + count]:
+                if f & ANCHOR:
+                    result.append((lineno + 1, self._strings[a],
+                                   self._string(b), self._strings[c_]))
+        return result
+
+    def write_xml(self, sxr):
+        """Export the content in the XML sxr format."""
+
+        writer = XMLWriter(sxr, self._filename)
+        for i in xrange(len(self._lines)):
+            if i: writer.newline()
+            text, spans = self.line(i)
+            column = 0
+            for c, l, f, a, b, c_ in spans:
+                writer.text(text[column:c])
+                if f & ANCHOR:
+                    writer.anchor(a, b, c_, text[c:c + l])
+                else:
+                    writer.span(a, text[c:c + l], f & CONTINUATION)
+                column = c + l
+            writer.text(text[column:])
+        writer.close()
+
+
+try:
+    from ReaderImpl import Reader, XMLWriter, is_binary
+except ImportError:
+    pass
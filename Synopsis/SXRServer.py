@@ -6,7 +6,7 @@
 #
 
 from Synopsis import IR
-import os, fnmatch
+import os, fnmatch, re, bisect, threading, array
 
 def escape(text):
     """escape special characters ('&', '\"', '<', '>')"""
@@ -48,6 +48,11 @@ ident_search_form = """
     <td>
       <form method=\"get\" action=\"%(script)s/ident\">
         <input type="text" name="string" value="" size="15"/>
+        <select name="match">
+          <option value="exact">exact</option>
+          <option value="prefix">prefix</option>
+          <option value="substring">substring</option>
+        </select>
         <input type="submit" value="Find"/>
       </form>
     </td>
@@ -55,18 +60,150 @@ ident_search_form = """
 </table>
 """
 
+class SymbolIndex(object):
+    """In-memory index of symbol names, supporting prefix and substring
+    searches on their last component.
+
+    The distinct last components are kept in a sorted list, so prefix
+    searches are a binary search. For substring searches the same names
+    are concatenated into a single string, and a suffix array of that
+    string (the start positions of all suffixes, ordered by the name
+    part of the suffix) turns a substring search into a binary search
+    for the range of suffixes starting with it. Where that range is much
+    larger than the number of results asked for, scanning the string
+    with `str.find` finds the first of them sooner, and matches are
+    mapped back to names through a sorted table of offsets."""
+
+    def __init__(self, symbols):
+
+        table = {}
+        for s in symbols:
+            table.setdefault(s[-1], []).append(s)
+        self.names = table.keys()
+        self.names.sort()
+        self.symbols = [sorted(table[n]) for n in self.names]
+        self.offsets = []
+        offset = 1
+        for n in self.names:
+            self.offsets.append(offset)
+            offset += len(n) + 1
+        self.text = '\n' + '\n'.join(self.names) + '\n'
+        # Suffixes only need to be ordered up to the end of their name,
+        # as no search string spans two names.
+        suffixes = []
+        for k, (n, o) in enumerate(zip(self.names, self.offsets)):
+            suffixes.extend([(n[i:], o + i, k) for i in xrange(len(n))])
+        suffixes.sort()
+        self.suffixes = array.array('L', [p for s, p, k in suffixes])
+        # The name each suffix belongs to.
+        self.owners = array.array('L', [k for s, p, k in suffixes])
+
+    def prefix(self, prefix, limit = -1):
+        """Return the symbols whose last component starts with 'prefix'."""
+
+        result = []
+        i = bisect.bisect_left(self.names, prefix)
+        while i < len(self.names) and self.names[i].startswith(prefix):
+            result.extend(self.symbols[i])
+            if 0 <= limit <= len(result): return result[:limit]
+            i += 1
+        return result
+
+    def substring(self, string, limit = -1):
+        """Return the symbols whose last component contains 'string'."""
+
+        if not string or '\n' in string: return []
+        text, suffixes, size = self.text, self.suffixes, len(string)
+        # Find the first suffix not less than 'string'...
+        lo, hi = 0, len(suffixes)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if text[suffixes[mid]:suffixes[mid] + size] < string: lo = mid + 1
+            else: hi = mid
+        # ...and the first one past it that doesn't start with it.
+        begin, hi = lo, len(suffixes)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if text[suffixes[mid]:suffixes[mid] + size] == string: lo = mid + 1
+            else: hi = mid
+        if 0 <= limit and lo - begin > 4 * limit:
+            return self._scan(string, limit)
+        result = []
+        for i in sorted(set(self.owners[begin:lo])):
+            result.extend(self.symbols[i])
+            if 0 <= limit <= len(result): return result[:limit]
+        return result
+
+    def _scan(self, string, limit):
+
+        result = []
+        pos = self.text.find(string)
+        while pos != -1:
+            i = bisect.bisect_right(self.offsets, pos) - 1
+            result.extend(self.symbols[i])
+            if 0 <= limit <= len(result): return result[:limit]
+            # Continue after the end of this name.
+            pos = self.text.find(string, self.offsets[i] + len(self.names[i]))
+        return result
+
+
+class FileIndex(object):
+    """In-memory index of the files in the 'Source' directory, matched
+    against glob patterns by their base name without extension."""
+
+    def __init__(self, src_dir):
+
+        self.files = []
+        for base, dirs, files in os.walk(src_dir):
+            dirs.sort()
+            files.sort()
+            for f in files:
+                path = os.path.join(base, f)
+                if os.path.isfile(path):
+                    self.files.append((os.path.splitext(f)[0],
+                                       path[len(src_dir) + 1:]))
+
+    def search(self, pattern):
+
+        match = re.compile(fnmatch.translate(pattern)).match
+        return [path for name, path in self.files if match(name)]
+
+
 class SXRServer:
 
+    max_matches = 100
+    """Maximum number of results reported for prefix and substring searches."""
+
     def __init__(self, root, cgi_url, src_url,
                  template_file = None,
-                 sxr_prefix='/sxr'):
+                 sxr_prefix='/sxr',
+                 preload = False):
+        """Create a server for the cross-reference data found in 'root'.
+        A long-running server should set 'preload', to build the in-memory
+        symbol and file indexes up-front, rather than on first use."""
 
         self.cgi_url = cgi_url
         self.src_url = src_url
         self.src_dir = os.path.join(root, 'Source')
-        ir = IR.load(os.path.join(root, 'sxr.syn'))
-        self.data = ir.sxr
-        self.index = ir.sxr.index()
+        # Prefer the symbol database, if one was generated. As sqlite
+        # connections can't be shared between threads, each thread opens
+        # its own, so requests needn't be serialized. The in-memory
+        # symbol table is only ever read, and thus shared.
+        self.database = os.path.join(root, 'sxr.db')
+        if os.path.exists(self.database):
+            self.sxr = None
+        else:
+            self.database = None
+            self.sxr = IR.load(os.path.join(root, 'sxr.syn')).sxr
+            self.sxr_index = self.sxr.index()
+        self.local = threading.local()
+        # Only guards the lazy construction of the indexes below.
+        self.lock = threading.Lock()
+        self._symbols = None
+        self._files = None
+        if preload:
+            self.symbols()
+            self.files()
 
         if template_file:
             template = open(template_file).read()
@@ -75,6 +212,58 @@ class SXRServer:
         self.template = template.split("@CONTENT@")
 
 
+    def _connect(self):
+        """Return this thread's connection to the symbol database."""
+
+        if getattr(self.local, 'data', None) is None:
+            from Synopsis.SXRDatabase import Database
+            self.local.data = Database(self.database)
+            self.local.index = self.local.data.index()
+        return self.local
+
+
+    @property
+    def data(self):
+        """The symbol table, either an `SXR.SXR` or a `SXRDatabase.Database`."""
+
+        if self.database: return self._connect().data
+        return self.sxr
+
+
+    @property
+    def index(self):
+        """The index of the symbol table, by unqualified names."""
+
+        if self.database: return self._connect().index
+        return self.sxr_index
+
+
+    def symbols(self):
+        """Return the `SymbolIndex`, building it if necessary."""
+
+        if self._symbols is None:
+            self.lock.acquire()
+            try:
+                if self._symbols is None:
+                    self._symbols = SymbolIndex(self.data.keys())
+            finally:
+                self.lock.release()
+        return self._symbols
+
+
+    def files(self):
+        """Return the `FileIndex`, building it if necessary."""
+
+        if self._files is None:
+            self.lock.acquire()
+            try:
+                if self._files is None:
+                    self._files = FileIndex(self.src_dir)
+            finally:
+                self.lock.release()
+        return self._files
+
+
     def ident_ref(self, file, line, scope):
 
         if len(scope):
@@ -125,16 +314,7 @@ class SXRServer:
         html = self.template[0]
         html += file_search_form%{'script': self.cgi_url}
 
-        base_path_len = len(self.src_dir)
-        def find(result, base, files):
-
-           result.extend([os.path.join(base[base_path_len + 1:], file)
-                          for file in files
-                          if os.path.isfile(os.path.join(base, file)) and
-                          fnmatch.fnmatch(os.path.splitext(file)[0], pattern)])
-
-        result = []
-        os.path.walk(self.src_dir, find, result)
+        result = self.files().search(pattern)
         if result:
             html += '<ul>\n'
             for f in result:
@@ -145,13 +325,29 @@ class SXRServer:
         return html
     
 
-    def search_ident(self, name, qualified = False):
-        """Generate an identifier listing."""
+    def search_ident(self, name, qualified = False, match = 'exact'):
+        """Generate an identifier listing. Unqualified names are looked up
+        by their last component, which either is 'name' or, depending on
+        'match', starts with or contains it."""
 
         html = self.template[0]
         html += ident_search_form%{'script' : self.cgi_url}
 
-        if qualified:
+        if match in ('prefix', 'substring') and not qualified:
+            if match == 'prefix':
+                matches = self.symbols().prefix(name, self.max_matches)
+            else:
+                matches = self.symbols().substring(name, self.max_matches)
+            if matches:
+                html += 'Found (%d) possible matches:<br/>\n'%(len(matches))
+                html += '<ul>\n'
+                for name in matches:
+                    html += self.list_refs(self.data, name)
+                html += '</ul>\n'
+            else:
+                html += 'No matches found<br/>\n'
+
+        elif qualified:
             if '::' in name:
                 name = tuple(name.split('::'))
             else:
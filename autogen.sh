@@ -35,6 +35,8 @@ conf Synopsis/Parsers/Cpp
 conf_with_header Synopsis/Parsers/IDL
 conf Synopsis/Parsers/C
 conf Synopsis/Parsers/Cxx
+conf Synopsis/Processors
+conf Synopsis/SXRFormat
 conf tests
 conf doc
 conf sandbox
@@ -22,7 +22,7 @@ def prefix(list, pref): return [pref + x for x in list]
 version = '0.14'
 revision = open('revision').read()[:-1]
 
-py_packages = ["Synopsis",
+py_packages = ["Synopsis", "Synopsis.SXRFormat",
                "Synopsis.Parsers",
                "Synopsis.Parsers.IDL", "Synopsis.Parsers.Python",
                "Synopsis.Parsers.Cpp",
@@ -40,7 +40,9 @@ py_packages = ["Synopsis",
 ext_modules = [('Synopsis/Parsers/Cpp', 'ParserImpl' + module_ext),
                ('Synopsis/Parsers/IDL', '_omniidl' + module_ext),
                ('Synopsis/Parsers/C', 'ParserImpl' + module_ext),
-               ('Synopsis/Parsers/Cxx', 'ParserImpl' + module_ext)]
+               ('Synopsis/Parsers/Cxx', 'ParserImpl' + module_ext),
+               ('Synopsis/SXRFormat', 'ReaderImpl' + module_ext),
+               ('Synopsis/Processors', 'LinkerImpl' + module_ext)]
 
 scripts = ['synopsis', 'sxr-server']
 if sys.platform == "win32":
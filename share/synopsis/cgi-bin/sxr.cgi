@@ -31,4 +31,5 @@ if __name__ == '__main__':
     elif command == 'ident':
        name = form.has_key('string') and form['string'].value or None
        qualified = form.has_key('full')
-       print server.search_ident(name, qualified)
+       match = form.has_key('match') and form['match'].value or 'exact'
+       print server.search_ident(name, qualified, match)
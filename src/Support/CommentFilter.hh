@@ -0,0 +1,99 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#ifndef Support_CommentFilter_hh_
+#define Support_CommentFilter_hh_
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+
+namespace Synopsis
+{
+
+//. Selects the comments a comment filter of a given style (see
+//. Synopsis.Processors.Comments.Filter) may extract documentation from,
+//. so parsers can drop all others as they extract comments. The selection
+//. is conservative: a rejected comment would be filtered to nothing, but
+//. accepted comments still need to be run through the filter itself.
+class CommentFilter
+{
+public:
+  enum Style { ALL, C, SS, SSD, SSS, JAVA, QT};
+
+  //. Create a filter for the given style, one of '' (accept all comments),
+  //. 'c', 'ss', 'ssd', 'sss', 'java', and 'qt'.
+  CommentFilter(std::string const &style)
+  {
+    if (style.empty()) style_ = ALL;
+    else if (style == "c") style_ = C;
+    else if (style == "ss") style_ = SS;
+    else if (style == "ssd") style_ = SSD;
+    else if (style == "sss") style_ = SSS;
+    else if (style == "java") style_ = JAVA;
+    else if (style == "qt") style_ = QT;
+    else throw std::invalid_argument("unknown comment filter: " + style);
+  }
+
+  Style style() const { return style_;}
+
+  //. Return true if the given comment may contain documentation.
+  bool accept(char const *text, size_t len) const
+  {
+    char const *end = text + len;
+    switch (style_)
+    {
+      case ALL: return true;
+      case C: return contains(text, end, "/*");
+      case JAVA: return contains(text, end, "/**");
+      case SS: return any_line_starts_with(text, end, "//");
+      case SSD: return any_line_starts_with(text, end, "//.");
+      case SSS: return any_line_starts_with(text, end, "///");
+      case QT:
+      {
+        // Only the start of the comment's first line counts.
+        char const *line_end = std::find(text, end, '\n');
+        return (starts_with(text, line_end, "//!") ||
+                starts_with(text, line_end, "/*!"));
+      }
+    }
+    return true;
+  }
+
+  bool accept(std::string const &text) const
+  { return accept(text.data(), text.size());}
+
+private:
+  static bool contains(char const *begin, char const *end, char const *s)
+  { return std::search(begin, end, s, s + strlen(s)) != end;}
+
+  //. Return true if the text starts with 's', after blanks.
+  static bool starts_with(char const *begin, char const *end, char const *s)
+  {
+    while (begin != end && (*begin == ' ' || *begin == '\t')) ++begin;
+    size_t len = strlen(s);
+    return static_cast<size_t>(end - begin) >= len && std::equal(s, s + len, begin);
+  }
+
+  static bool any_line_starts_with(char const *begin, char const *end, char const *s)
+  {
+    while (true)
+    {
+      char const *line_end = std::find(begin, end, '\n');
+      if (starts_with(begin, line_end, s)) return true;
+      if (line_end == end) return false;
+      begin = line_end + 1;
+    }
+  }
+
+  Style style_;
+};
+
+}
+
+#endif
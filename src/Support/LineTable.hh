@@ -0,0 +1,52 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#ifndef Support_LineTable_hh_
+#define Support_LineTable_hh_
+
+#include <algorithm>
+#include <vector>
+
+namespace Synopsis
+{
+
+//. Maps byte offsets in a source file to line and column numbers, both
+//. starting at 1, the way clang counts them. A line ends with "\n", "\r",
+//. "\r\n" or "\n\r". The table holds the offset at which each line starts,
+//. so lookups are binary searches.
+class LineTable
+{
+public:
+  LineTable(char const *begin, char const *end)
+  {
+    starts_.push_back(0);
+    for (char const *i = begin; i != end; ++i)
+      if (*i == '\n' || *i == '\r')
+      {
+        if (i + 1 != end && (i[1] == '\n' || i[1] == '\r') && i[1] != *i) ++i;
+        starts_.push_back(i + 1 - begin);
+      }
+  }
+
+  //. Return the line containing 'offset'. Lines before 'hint' aren't
+  //. searched, so scanning a file in order only searches what is left.
+  unsigned line(unsigned offset, unsigned hint = 1) const
+  {
+    std::vector<unsigned>::const_iterator begin = starts_.begin() + (hint - 1);
+    if (begin >= starts_.end() || *begin > offset) begin = starts_.begin();
+    return std::upper_bound(begin, starts_.end(), offset) - starts_.begin();
+  }
+  unsigned column(unsigned offset, unsigned line) const
+  { return offset - starts_[line - 1] + 1;}
+
+private:
+  std::vector<unsigned> starts_;
+};
+
+}
+
+#endif
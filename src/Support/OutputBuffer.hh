@@ -0,0 +1,156 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#ifndef Support_OutputBuffer_hh_
+#define Support_OutputBuffer_hh_
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__SSE2__) && defined(__GNUC__)
+# include <emmintrin.h>
+# define SYNOPSIS_SSE2 1
+#endif
+
+namespace Synopsis
+{
+
+//. Return the first of '&', '<', '>', and '"' in [begin, end), or 'end'.
+//. Where SSE2 is available, 16 characters are checked at a time.
+inline char const *find_xml_special(char const *begin, char const *end)
+{
+#ifdef SYNOPSIS_SSE2
+  __m128i const amp = _mm_set1_epi8('&');
+  __m128i const lt = _mm_set1_epi8('<');
+  __m128i const gt = _mm_set1_epi8('>');
+  __m128i const quot = _mm_set1_epi8('"');
+  for (; end - begin >= 16; begin += 16)
+  {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(begin));
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, amp), _mm_cmpeq_epi8(c, lt)),
+                             _mm_or_si128(_mm_cmpeq_epi8(c, gt), _mm_cmpeq_epi8(c, quot)));
+    if (int mask = _mm_movemask_epi8(m)) return begin + __builtin_ctz(mask);
+  }
+#endif
+  for (; begin != end; ++begin)
+    switch (*begin)
+    {
+      case '&': case '<': case '>': case '"': return begin;
+      default: break;
+    }
+  return end;
+}
+
+//. An output file, written through a large buffer. Text is copied
+//. into the buffer in bulk, and the buffer is written out when full.
+class OutputBuffer
+{
+public:
+  enum { SIZE = 1 << 16};
+
+  OutputBuffer(std::string const &filename)
+    : file_(std::fopen(filename.c_str(), "wb")),
+      buffer_(SIZE),
+      size_(0)
+  {
+    if (!file_) throw std::runtime_error("unable to open " + filename);
+  }
+  ~OutputBuffer()
+  {
+    if (!file_) return;
+    flush();
+    std::fclose(file_);
+  }
+
+  void put(char c)
+  {
+    if (size_ == SIZE) flush();
+    buffer_[size_++] = c;
+  }
+  void write(char const *t, size_t len)
+  {
+    if (len > SIZE - size_)
+    {
+      flush();
+      if (len >= SIZE)
+      {
+        std::fwrite(t, 1, len, file_);
+        return;
+      }
+    }
+    std::memcpy(&buffer_[size_], t, len);
+    size_ += len;
+  }
+  //. Write a string literal, without measuring it at runtime.
+  template <size_t N>
+  void write(char const (&literal)[N]) { write(literal, N - 1);}
+  void write(std::string const &s) { write(s.data(), s.size());}
+  //. Write 'n' copies of 'c', such as indentation.
+  void fill(char c, size_t n)
+  {
+    while (n)
+    {
+      if (size_ == SIZE) flush();
+      size_t len = std::min(n, SIZE - size_);
+      std::memset(&buffer_[size_], c, len);
+      size_ += len;
+      n -= len;
+    }
+  }
+  //. Write text with XML special characters replaced by entities.
+  //. Runs of plain characters are copied in one go.
+  void write_escaped(char const *t, size_t len)
+  {
+    char const *end = t + len;
+    while (true)
+    {
+      char const *s = find_xml_special(t, end);
+      write(t, s - t);
+      if (s == end) return;
+      switch (*s)
+      {
+        case '&': write("&amp;"); break;
+        case '<': write("&lt;"); break;
+        case '>': write("&gt;"); break;
+        default: write("&quot;"); break;
+      }
+      t = s + 1;
+    }
+  }
+  void write_escaped(std::string const &s) { write_escaped(s.data(), s.size());}
+
+  void flush()
+  {
+    if (size_) std::fwrite(&buffer_[0], 1, size_, file_);
+    size_ = 0;
+  }
+  //. Flush and close the file, reporting any error.
+  void close()
+  {
+    if (!file_) return;
+    flush();
+    bool error = std::ferror(file_);
+    error |= std::fclose(file_) != 0;
+    file_ = 0;
+    if (error) throw std::runtime_error("error writing output");
+  }
+
+private:
+  OutputBuffer(OutputBuffer const &);
+  OutputBuffer &operator=(OutputBuffer const &);
+
+  std::FILE        *file_;
+  std::vector<char> buffer_;
+  size_t            size_;
+};
+
+}
+
+#endif
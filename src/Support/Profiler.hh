@@ -0,0 +1,185 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#ifndef Support_Profiler_hh_
+#define Support_Profiler_hh_
+
+#ifdef _WIN32
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <windows.h>
+#else
+# include <sys/time.h>
+# include <sys/resource.h>
+#endif
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Synopsis
+{
+
+//. A hierarchical profiler. Code to be profiled is marked by 'Profiler::Zone'
+//. objects, which record the wall-clock and CPU time spent between their
+//. construction and destruction, the peak resident set size, and any counters
+//. incremented by 'Profiler::count' inside them. Zones nest, and each one is
+//. recorded as an event, so repeated zones show up as multiple calls.
+//. Unless the profiler is enabled, zones and counters don't do anything.
+//.
+//. The recorded events are passed on to the Synopsis.Profiler Python module
+//. (see Support/PythonProfiler.hh), which reports them together with the
+//. events recorded in Python.
+class Profiler
+{
+public:
+  typedef std::vector<std::pair<char const *, long> > Counters;
+
+  struct Event
+  {
+    //. The zone's name. Names are expected to be string literals.
+    char const *name;
+    //. Wall-clock time at the start of the zone, in microseconds since the epoch.
+    double start;
+    //. Wall-clock time spent in the zone, in microseconds.
+    double wall;
+    //. CPU time spent in the zone, in microseconds.
+    double cpu;
+    //. Nesting depth of the zone.
+    unsigned depth;
+    //. Peak resident set size at the end of the zone, in kilobytes.
+    //. It isn't measured on Windows, where it is always 0.
+    long rss;
+    Counters counters;
+  };
+  typedef std::vector<Event> Events;
+
+  class Zone
+  {
+  public:
+    Zone(char const *name)
+      : profiler_(instance().enabled_ ? &instance() : 0)
+    { if (profiler_) index_ = profiler_->open(name);}
+    ~Zone() { if (profiler_) profiler_->close(index_);}
+  private:
+    Zone(Zone const &);
+    Zone &operator=(Zone const &);
+
+    Profiler *profiler_;
+    size_t    index_;
+  };
+
+  static Profiler &instance() { static Profiler profiler; return profiler;}
+
+  static void enable(bool e = true) { instance().enabled_ = e;}
+  static bool enabled() { return instance().enabled_;}
+
+  //. Add 'n' to the named counter of the innermost zone.
+  static void count(char const *name, long n = 1)
+  {
+    Profiler &p = instance();
+    if (!p.enabled_ || p.stack_.empty()) return;
+    Counters &counters = p.events_[p.stack_.back()].counters;
+    for (Counters::iterator i = counters.begin(); i != counters.end(); ++i)
+      if (i->first == name || std::strcmp(i->first, name) == 0)
+      {
+        i->second += n;
+        return;
+      }
+    counters.push_back(std::make_pair(name, n));
+  }
+
+  //. Return the events of all completed zones, and forget them.
+  //. Zones still open are kept.
+  Events take_events()
+  {
+    Events events;
+    if (stack_.empty()) events.swap(events_);
+    return events;
+  }
+
+private:
+  Profiler() : enabled_(false) {}
+
+#ifdef _WIN32
+  //. Convert a FILETIME, counting 100ns intervals, to microseconds.
+  static double microseconds(FILETIME const &t)
+  { return (double(t.dwHighDateTime) * 4294967296. + t.dwLowDateTime) / 10;}
+
+  static double wall_time()
+  {
+    // FILETIME counts from 1601, the epoch is 11644473600 seconds later.
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    return microseconds(now) - 11644473600e6;
+  }
+
+  static double cpu_time()
+  {
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+      return 0.;
+    return microseconds(kernel) + microseconds(user);
+  }
+
+  static long peak_rss() { return 0;}
+#else
+  static double wall_time()
+  {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+  }
+
+  static double cpu_time()
+  {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+      usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+  }
+
+  static long peak_rss()
+  {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+#endif
+
+  size_t open(char const *name)
+  {
+    Event event;
+    event.name = name;
+    event.depth = stack_.size();
+    event.rss = 0;
+    // Until the zone is closed, 'wall' and 'cpu' hold the start times.
+    event.start = event.wall = wall_time();
+    event.cpu = cpu_time();
+    events_.push_back(event);
+    stack_.push_back(events_.size() - 1);
+    return events_.size() - 1;
+  }
+
+  void close(size_t index)
+  {
+    Event &event = events_[index];
+    event.wall = wall_time() - event.wall;
+    event.cpu = cpu_time() - event.cpu;
+    event.rss = peak_rss();
+    stack_.pop_back();
+  }
+
+  bool                enabled_;
+  Events              events_;
+  std::vector<size_t> stack_;
+};
+
+}
+
+#endif
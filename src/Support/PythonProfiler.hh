@@ -0,0 +1,66 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#ifndef Support_PythonProfiler_hh_
+#define Support_PythonProfiler_hh_
+
+#include <Support/Profiler.hh>
+#include <boost/python.hpp>
+
+namespace Synopsis
+{
+
+//. Pass the events recorded by the Profiler to the Synopsis.Profiler
+//. Python module, nested inside the Python zone currently open.
+inline void submit_profile()
+{
+  namespace bpl = boost::python;
+
+  Profiler::Events events = Profiler::instance().take_events();
+  if (events.empty()) return;
+  bpl::list result;
+  for (Profiler::Events::const_iterator i = events.begin(); i != events.end(); ++i)
+  {
+    bpl::dict counters;
+    for (Profiler::Counters::const_iterator c = i->counters.begin();
+         c != i->counters.end();
+         ++c)
+      counters[c->first] = c->second;
+    result.append(bpl::make_tuple(i->name, i->start, i->wall, i->cpu,
+                                  i->depth, i->rss, counters));
+  }
+  bpl::import("Synopsis.Profiler").attr("add")(result);
+}
+
+//. Enable the Profiler if 'profile' is set, and submit the recorded
+//. events when going out of scope, so they are reported however the
+//. profiled function is left, including by an exception.
+class ProfileSubmitter
+{
+public:
+  ProfileSubmitter(bool profile) : profile_(profile) { Profiler::enable(profile);}
+  ~ProfileSubmitter()
+  {
+    if (!profile_) return;
+    // Set a pending Python error aside while calling into Python,
+    // and don't let a failure to submit replace it.
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    try { submit_profile();}
+    catch (...) { PyErr_Clear();}
+    PyErr_Restore(type, value, traceback);
+  }
+private:
+  ProfileSubmitter(ProfileSubmitter const &);
+  ProfileSubmitter &operator=(ProfileSubmitter const &);
+
+  bool profile_;
+};
+
+}
+
+#endif
@@ -0,0 +1,421 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#ifndef Support_SXR_hh_
+#define Support_SXR_hh_
+
+#include <Support/OutputBuffer.hh>
+#include <zlib.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstring>
+
+namespace Synopsis
+{
+namespace SXR
+{
+
+//. Sink for the content of a cross-referenced source file.
+//. Generators report plain text, highlighted spans and cross-reference
+//. anchors line by line, and the writer encodes them in a given format.
+//. All text is passed unescaped.
+class Writer
+{
+public:
+  virtual ~Writer() {}
+  //. Plain source text.
+  virtual void text(char const *, size_t) = 0;
+  //. Highlighted text, such as a keyword or a comment. A continuation
+  //. span continues a multi-line span from a previous line.
+  virtual void span(char const *cls, char const *text, size_t len,
+                    bool continuation = false) = 0;
+  //. A cross-reference anchor. 'from' may be empty.
+  virtual void anchor(std::string const &href, std::string const &from,
+                      char const *type, char const *text, size_t len) = 0;
+  //. Plain whitespace, such as indentation.
+  virtual void space(size_t n) { text(std::string(n, ' '));}
+  //. Start a new line.
+  virtual void newline() = 0;
+  //. Finish the file.
+  virtual void close() = 0;
+
+  void text(std::string const &t) { text(t.data(), t.size());}
+};
+
+//. Writes the traditional XML sxr format.
+class XMLWriter : public Writer
+{
+public:
+  XMLWriter(std::string const &sxr, std::string const &filename)
+    : obuf_(sxr)
+  {
+    obuf_.write("<sxr filename=\"");
+    obuf_.write_escaped(filename);
+    obuf_.write("\">\n<line>");
+  }
+  virtual void text(char const *t, size_t len) { obuf_.write_escaped(t, len);}
+  virtual void space(size_t n) { obuf_.fill(' ', n);}
+  virtual void span(char const *cls, char const *t, size_t len, bool continuation)
+  {
+    obuf_.write("<span class=\"");
+    obuf_.write(cls, strlen(cls));
+    if (continuation) obuf_.write("\" continuation=\"true");
+    obuf_.write("\">");
+    obuf_.write_escaped(t, len);
+    obuf_.write("</span>");
+  }
+  virtual void anchor(std::string const &href, std::string const &from,
+                      char const *type, char const *t, size_t len)
+  {
+    obuf_.write("<a href=\"");
+    obuf_.write_escaped(href);
+    if (!from.empty())
+    {
+      obuf_.write("\" from=\"");
+      obuf_.write_escaped(from);
+    }
+    obuf_.write("\" type=\"");
+    obuf_.write(type, strlen(type));
+    obuf_.write("\">");
+    obuf_.write_escaped(t, len);
+    obuf_.write("</a>");
+  }
+  virtual void newline() { obuf_.write("</line>\n<line>");}
+  virtual void close()
+  {
+    obuf_.write("</line>\n</sxr>\n");
+    obuf_.close();
+  }
+
+private:
+  OutputBuffer obuf_;
+};
+
+//. The binary sxr format. All integers are 32 bit little-endian.
+//.
+//.   header:  "SXB" 1, flags, payload size
+//.   payload: (zlib-compressed if flags & COMPRESSED)
+//.            filename (string id), #strings, #lines, #spans, text size
+//.            strings: (length, bytes)*
+//.            lines:   (text offset, text length, first span, #spans)*
+//.            spans:   (column, length, flags, a, b, c)*
+//.            text:    the source text, without line breaks
+//.
+//. A span with the ANCHOR flag refers to the strings (href, from, type),
+//. others to (class, NONE, NONE). Columns are relative to the line start.
+namespace Binary
+{
+char const magic[4] = {'S', 'X', 'B', '\1'};
+enum { COMPRESSED = 1};
+enum { ANCHOR = 1, CONTINUATION = 2};
+unsigned const NONE = 0xffffffff;
+//. deflate can't compress better than about 1032:1, so a larger
+//. payload size in the header means the file is corrupt.
+unsigned const MAX_RATIO = 1032;
+
+struct Line
+{
+  unsigned offset, length, first_span, spans;
+};
+
+struct Span
+{
+  unsigned column, length, flags, a, b, c;
+  bool is_anchor() const { return flags & ANCHOR;}
+  bool is_continuation() const { return flags & CONTINUATION;}
+};
+
+inline void put(std::string &buf, unsigned v)
+{
+  char b[4] = {char(v & 0xff), char((v >> 8) & 0xff),
+               char((v >> 16) & 0xff), char((v >> 24) & 0xff)};
+  buf.append(b, 4);
+}
+
+inline unsigned get(char const *&p, char const *end)
+{
+  if (end - p < 4) throw std::runtime_error("truncated sxr file");
+  unsigned char const *b = reinterpret_cast<unsigned char const *>(p);
+  p += 4;
+  return b[0] | (b[1] << 8) | (b[2] << 16) | (unsigned(b[3]) << 24);
+}
+}
+
+//. Writes the binary sxr format, optionally compressed.
+class BinaryWriter : public Writer
+{
+public:
+  BinaryWriter(std::string const &sxr, std::string const &filename, bool compress)
+    : sxr_(sxr), compress_(compress), line_start_(0)
+  {
+    filename_ = intern(filename);
+  }
+  virtual void text(char const *t, size_t len) { text_.append(t, len);}
+  virtual void span(char const *cls, char const *t, size_t len, bool continuation)
+  {
+    Binary::Span s = {column(), unsigned(len),
+                      continuation ? unsigned(Binary::CONTINUATION) : 0,
+                      intern(cls), Binary::NONE, Binary::NONE};
+    spans_.push_back(s);
+    text_.append(t, len);
+  }
+  virtual void anchor(std::string const &href, std::string const &from,
+                      char const *type, char const *t, size_t len)
+  {
+    Binary::Span s = {column(), unsigned(len), Binary::ANCHOR,
+                      intern(href), from.empty() ? Binary::NONE : intern(from),
+                      intern(type)};
+    spans_.push_back(s);
+    text_.append(t, len);
+  }
+  virtual void newline()
+  {
+    unsigned first = lines_.empty() ? 0 : lines_.back().first_span + lines_.back().spans;
+    Binary::Line l = {line_start_, unsigned(text_.size()) - line_start_,
+                      first, unsigned(spans_.size()) - first};
+    lines_.push_back(l);
+    line_start_ = text_.size();
+  }
+  virtual void close()
+  {
+    newline();
+    std::string payload;
+    Binary::put(payload, filename_);
+    Binary::put(payload, strings_.size());
+    Binary::put(payload, lines_.size());
+    Binary::put(payload, spans_.size());
+    Binary::put(payload, text_.size());
+    for (std::vector<std::string>::iterator i = strings_.begin(); i != strings_.end(); ++i)
+    {
+      Binary::put(payload, i->size());
+      payload += *i;
+    }
+    for (std::vector<Binary::Line>::iterator i = lines_.begin(); i != lines_.end(); ++i)
+    {
+      Binary::put(payload, i->offset);
+      Binary::put(payload, i->length);
+      Binary::put(payload, i->first_span);
+      Binary::put(payload, i->spans);
+    }
+    for (std::vector<Binary::Span>::iterator i = spans_.begin(); i != spans_.end(); ++i)
+    {
+      Binary::put(payload, i->column);
+      Binary::put(payload, i->length);
+      Binary::put(payload, i->flags);
+      Binary::put(payload, i->a);
+      Binary::put(payload, i->b);
+      Binary::put(payload, i->c);
+    }
+    payload += text_;
+
+    std::string header(Binary::magic, 4);
+    Binary::put(header, compress_ ? Binary::COMPRESSED : 0);
+    Binary::put(header, payload.size());
+    if (compress_)
+    {
+      uLongf size = compressBound(payload.size());
+      std::vector<Bytef> buffer(size);
+      if (compress2(&buffer[0], &size,
+                    reinterpret_cast<Bytef const *>(payload.data()), payload.size(),
+                    Z_DEFAULT_COMPRESSION) != Z_OK)
+        throw std::runtime_error("unable to compress " + sxr_);
+      payload.assign(reinterpret_cast<char const *>(&buffer[0]), size);
+    }
+    std::ofstream os(sxr_.c_str(), std::ios_base::out | std::ios_base::binary);
+    os.write(header.data(), header.size());
+    os.write(payload.data(), payload.size());
+    if (!os) throw std::runtime_error("unable to write " + sxr_);
+  }
+
+private:
+  unsigned column() const { return text_.size() - line_start_;}
+  unsigned intern(std::string const &s)
+  {
+    std::map<std::string, unsigned>::iterator i = ids_.find(s);
+    if (i != ids_.end()) return i->second;
+    strings_.push_back(s);
+    return ids_[s] = strings_.size() - 1;
+  }
+
+  std::string                      sxr_;
+  bool                             compress_;
+  unsigned                         filename_;
+  std::vector<std::string>         strings_;
+  std::map<std::string, unsigned>  ids_;
+  std::vector<Binary::Line>        lines_;
+  std::vector<Binary::Span>        spans_;
+  std::string                      text_;
+  unsigned                         line_start_;
+};
+
+//. Create a writer for the given format ("xml", "binary", or "compressed").
+inline Writer *make_writer(std::string const &format,
+                           std::string const &sxr, std::string const &filename)
+{
+  if (format.empty() || format == "xml") return new XMLWriter(sxr, filename);
+  else if (format == "binary") return new BinaryWriter(sxr, filename, false);
+  else if (format == "compressed") return new BinaryWriter(sxr, filename, true);
+  else throw std::invalid_argument("unknown sxr format: " + format);
+}
+
+//. Reads a binary sxr file into memory.
+class Reader
+{
+public:
+  typedef Binary::Line Line;
+  typedef Binary::Span Span;
+
+  //. Return true if the given file is in the binary sxr format.
+  static bool is_binary(std::string const &sxr)
+  {
+    std::ifstream is(sxr.c_str(), std::ios_base::in | std::ios_base::binary);
+    char magic[4];
+    return is.read(magic, 4) && std::equal(magic, magic + 4, Binary::magic);
+  }
+
+  Reader(std::string const &sxr)
+  {
+    std::ifstream is(sxr.c_str(), std::ios_base::in | std::ios_base::binary);
+    std::string data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    if (data.size() < 12 || !std::equal(data.begin(), data.begin() + 4, Binary::magic))
+      throw std::runtime_error(sxr + " is not a binary sxr file");
+    char const *p = data.data() + 4, *end = data.data() + data.size();
+    unsigned flags = Binary::get(p, end);
+    uLongf size = Binary::get(p, end);
+    std::string payload;
+    if (flags & Binary::COMPRESSED)
+    {
+      if (size / Binary::MAX_RATIO > size_t(end - p))
+        throw std::runtime_error("corrupt sxr file");
+      payload.resize(size);
+      if (uncompress(reinterpret_cast<Bytef *>(&payload[0]), &size,
+                     reinterpret_cast<Bytef const *>(p), end - p) != Z_OK ||
+          size != payload.size())
+        throw std::runtime_error("unable to uncompress " + sxr);
+    }
+    else
+      payload.assign(p, end);
+
+    p = payload.data(), end = payload.data() + payload.size();
+    filename_ = Binary::get(p, end);
+    size_t strings = Binary::get(p, end);
+    size_t lines = Binary::get(p, end);
+    size_t spans = Binary::get(p, end);
+    size_t text_size = Binary::get(p, end);
+    // Strings take at least 4 bytes each, lines 16, and spans 24.
+    size_t left = end - p;
+    if (left / 4 < strings || left / 16 < lines || left / 24 < spans)
+      throw std::runtime_error("truncated sxr file");
+    strings_.resize(strings);
+    lines_.resize(lines);
+    spans_.resize(spans);
+    for (std::vector<std::string>::iterator i = strings_.begin(); i != strings_.end(); ++i)
+    {
+      size_t length = Binary::get(p, end);
+      if (size_t(end - p) < length) throw std::runtime_error("truncated sxr file");
+      i->assign(p, length);
+      p += length;
+    }
+    for (std::vector<Line>::iterator i = lines_.begin(); i != lines_.end(); ++i)
+    {
+      i->offset = Binary::get(p, end);
+      i->length = Binary::get(p, end);
+      i->first_span = Binary::get(p, end);
+      i->spans = Binary::get(p, end);
+    }
+    for (std::vector<Span>::iterator i = spans_.begin(); i != spans_.end(); ++i)
+    {
+      i->column = Binary::get(p, end);
+      i->length = Binary::get(p, end);
+      i->flags = Binary::get(p, end);
+      i->a = Binary::get(p, end);
+      i->b = Binary::get(p, end);
+      i->c = Binary::get(p, end);
+    }
+    if (size_t(end - p) != text_size) throw std::runtime_error("truncated sxr file");
+    text_.assign(p, end);
+    validate();
+  }
+
+  std::string const &filename() const { return strings_.at(filename_);}
+  size_t lines() const { return lines_.size();}
+  Line const &line(size_t i) const { return lines_.at(i);}
+  Span const &span(size_t i) const { return spans_.at(i);}
+  std::string const &string(unsigned i) const { return strings_.at(i);}
+  //. Return the text of the given line.
+  std::string text(Line const &l) const { return text_.substr(l.offset, l.length);}
+  //. Return the text covered by the given span on the given line.
+  std::string text(Line const &l, Span const &s) const
+  { return text_.substr(l.offset + s.column, s.length);}
+
+  //. Export the content in the XML sxr format.
+  void write_xml(std::string const &sxr) const
+  {
+    XMLWriter writer(sxr, filename());
+    for (size_t i = 0; i != lines_.size(); ++i)
+    {
+      if (i) writer.newline();
+      Line const &l = lines_[i];
+      char const *t = text_.data() + l.offset;
+      unsigned column = 0;
+      for (unsigned j = l.first_span; j != l.first_span + l.spans; ++j)
+      {
+        Span const &s = spans_.at(j);
+        writer.text(t + column, s.column - column);
+        if (s.is_anchor())
+          writer.anchor(string(s.a), s.b == Binary::NONE ? std::string() : string(s.b),
+                        string(s.c).c_str(), t + s.column, s.length);
+        else
+          writer.span(string(s.a).c_str(), t + s.column, s.length, s.is_continuation());
+        column = s.column + s.length;
+      }
+      writer.text(t + column, l.length - column);
+    }
+    writer.close();
+  }
+
+private:
+  //. Make sure all lines lie within the text, all spans within their
+  //. line, in order, and that all string ids are valid, so a corrupt
+  //. file can't make us read out of bounds.
+  void validate() const
+  {
+    if (filename_ >= strings_.size()) throw std::runtime_error("corrupt sxr file");
+    for (std::vector<Line>::const_iterator i = lines_.begin(); i != lines_.end(); ++i)
+    {
+      if (i->offset > text_.size() || i->length > text_.size() - i->offset ||
+          i->first_span > spans_.size() || i->spans > spans_.size() - i->first_span)
+        throw std::runtime_error("corrupt sxr file");
+      unsigned column = 0;
+      for (unsigned j = i->first_span; j != i->first_span + i->spans; ++j)
+      {
+        Span const &s = spans_[j];
+        if (s.column < column || s.column > i->length || s.length > i->length - s.column ||
+            !valid(s.a, false) || !valid(s.b, true) || !valid(s.c, !s.is_anchor()))
+          throw std::runtime_error("corrupt sxr file");
+        column = s.column + s.length;
+      }
+    }
+  }
+  bool valid(unsigned string, bool optional) const
+  { return string < strings_.size() || (optional && string == Binary::NONE);}
+
+  unsigned                 filename_;
+  std::vector<std::string> strings_;
+  std::vector<Line>        lines_;
+  std::vector<Span>        spans_;
+  std::string              text_;
+};
+
+}
+}
+
+#endif
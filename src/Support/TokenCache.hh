@@ -0,0 +1,156 @@
+//
+// Copyright (C) 2011 Stefan Seefeld
+// All rights reserved.
+// Licensed to the public under the terms of the GNU LGPL (>= 2),
+// see the file COPYING for details.
+//
+
+#ifndef Support_TokenCache_hh_
+#define Support_TokenCache_hh_
+
+#include <Support/Profiler.hh>
+#include <clang-c/Index.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Synopsis
+{
+
+//. The tokens of the files of a translation unit. A file is tokenized
+//. as a whole the first time tokens are asked for, and the spellings of
+//. all its tokens are kept back to back in a single string. The tokens
+//. of a source range, and their spellings, are then slices of that cache,
+//. instead of a call to clang_tokenize and one to clang_getTokenSpelling
+//. per token.
+class TokenCache
+{
+  struct Token
+  {
+    unsigned    begin;    // offset in the file
+    unsigned    end;
+    CXTokenKind kind;
+    size_t      spelling; // offset in File::spellings
+    size_t      length;
+  };
+  typedef std::vector<Token> Tokens;
+  struct File
+  {
+    Tokens      tokens;
+    std::string spellings;
+  };
+  typedef std::map<CXFile, File> Files;
+
+public:
+  //. A sequence of tokens.
+  class Range
+  {
+  public:
+    Range() : file_(0), begin_(0), end_(0) {}
+    size_t size() const { return end_ - begin_;}
+    CXTokenKind kind(size_t i) const { return token(i).kind;}
+    //. The spelling of the i'th token. It is not null-terminated.
+    char const *data(size_t i) const { return file_->spellings.data() + token(i).spelling;}
+    size_t length(size_t i) const { return token(i).length;}
+    std::string spelling(size_t i) const { return std::string(data(i), length(i));}
+
+  private:
+    friend class TokenCache;
+    Range(File const *file, size_t begin, size_t end)
+      : file_(file), begin_(begin), end_(end) {}
+    Token const &token(size_t i) const { return file_->tokens[begin_ + i];}
+
+    File const *file_;
+    size_t      begin_;
+    size_t      end_;
+  };
+
+  TokenCache() : tu_(0) {}
+
+  //. Forget all files, and take tokens from 'tu' from now on.
+  void reset(CXTranslationUnit tu) { tu_ = tu; files_.clear();}
+
+  //. Return the tokens clang_tokenize would return for 'r': those starting
+  //. inside it, and, as clang_tokenize lexes on until a token reaches the
+  //. end of the range, the one after the last of them if that falls short.
+  Range tokens(CXSourceRange r)
+  {
+    CXFile f;
+    unsigned begin, end;
+    clang_getSpellingLocation(clang_getRangeStart(r), &f, 0, 0, &begin);
+    clang_getSpellingLocation(clang_getRangeEnd(r), 0, 0, 0, &end);
+    if (!f) return Range();
+    File const &file = this->file(f);
+    Tokens::const_iterator first = std::lower_bound(file.tokens.begin(), file.tokens.end(),
+                                                    begin, begins_before);
+    Tokens::const_iterator last = std::lower_bound(first, file.tokens.end(), end, ends_before);
+    if (last != file.tokens.end()) ++last;
+    return Range(&file, first - file.tokens.begin(), last - file.tokens.begin());
+  }
+
+  //. Return the spellings of the tokens in 'r', each preceded by a blank.
+  std::string stringify(CXSourceRange r)
+  {
+    Range tokens = this->tokens(r);
+    std::string value;
+    for (size_t i = 0; i != tokens.size(); ++i)
+    {
+      value += ' ';
+      value.append(tokens.data(i), tokens.length(i));
+    }
+    return value;
+  }
+
+private:
+  static bool begins_before(Token const &t, unsigned offset) { return t.begin < offset;}
+  static bool ends_before(Token const &t, unsigned offset) { return t.end < offset;}
+
+  File const &file(CXFile f)
+  {
+    Files::iterator i = files_.find(f);
+    if (i != files_.end()) return i->second;
+    File &file = files_[f];
+
+    CXString name = clang_getFileName(f);
+    struct stat status;
+    bool found = stat(clang_getCString(name), &status) == 0;
+    clang_disposeString(name);
+    if (!found) return file;
+    CXSourceRange range = clang_getRange(clang_getLocationForOffset(tu_, f, 0),
+                                         clang_getLocationForOffset(tu_, f, status.st_size));
+    CXToken *tokens;
+    unsigned num_tokens;
+    clang_tokenize(tu_, range, &tokens, &num_tokens);
+    Profiler::count("cached tokens", num_tokens);
+    file.tokens.reserve(num_tokens);
+    for (unsigned i = 0; i != num_tokens; ++i)
+    {
+      Token t;
+      // A token's spelling may be shorter than its extent, if a line
+      // splice or a trigraph occurs within it.
+      CXSourceRange extent = clang_getTokenExtent(tu_, tokens[i]);
+      clang_getSpellingLocation(clang_getRangeStart(extent), 0, 0, 0, &t.begin);
+      clang_getSpellingLocation(clang_getRangeEnd(extent), 0, 0, 0, &t.end);
+      t.kind = clang_getTokenKind(tokens[i]);
+      CXString s = clang_getTokenSpelling(tu_, tokens[i]);
+      char const *spelling = clang_getCString(s);
+      t.spelling = file.spellings.size();
+      t.length = std::strlen(spelling);
+      file.spellings.append(spelling, t.length);
+      clang_disposeString(s);
+      file.tokens.push_back(t);
+    }
+    clang_disposeTokens(tu_, tokens, num_tokens);
+    return file;
+  }
+
+  CXTranslationUnit tu_;
+  Files             files_;
+};
+
+}
+
+#endif
@@ -99,20 +99,4 @@ inline std::string cursor_location(CXCursor c, bool extent = false)
   return oss.str();
 }
 
-inline std::string stringify_range(CXTranslationUnit tu, CXSourceRange r)
-{
-  CXToken *tokens;
-  unsigned num_tokens;
-  clang_tokenize(tu, r, &tokens, &num_tokens);
-  std::ostringstream oss;
-  for (unsigned i = 0; i != num_tokens; ++i) 
-  {
-    CXString t = clang_getTokenSpelling(tu, tokens[i]);
-    oss << ' ' << clang_getCString(t);
-    clang_disposeString(t);
-  }
-  clang_disposeTokens(tu, tokens, num_tokens);  
-  return oss.str();
-}
-
 #endif
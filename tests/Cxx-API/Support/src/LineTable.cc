@@ -0,0 +1,37 @@
+#include <Support/LineTable.hh>
+#include <string>
+#include <iostream>
+
+using namespace Synopsis;
+
+// Print the line and column of the first character of each line.
+void test(std::string const &title, std::string const &source)
+{
+  std::cout << title << std::endl;
+  LineTable lines(source.data(), source.data() + source.size());
+  unsigned line = 1;
+  for (unsigned offset = 0; offset != source.size(); ++offset)
+    if (source[offset] != '\n' && source[offset] != '\r')
+    {
+      unsigned l = lines.line(offset, line);
+      unsigned c = lines.column(offset, l);
+      if (c == 1) std::cout << source[offset] << ' ' << l << ':' << c << std::endl;
+      line = l;
+    }
+}
+
+int main(int, char **)
+{  
+  try
+  {
+    test("unix", "a\nb\n\nc\n");
+    test("dos", "a\r\nb\r\n\r\nc\r\n");
+    test("mac", "a\rb\r\rc\r");
+    test("\\n\\r", "a\n\rb\n\r\n\rc\n\r");
+    test("mixed", "a\r\nb\n\rc\nd\re\r\n\rf\n\r\ng\r\r\nh");
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << "Error : " << e.what() << std::endl;
+  }
+}
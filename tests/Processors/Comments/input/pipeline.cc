@@ -0,0 +1,30 @@
+// -*- Comments.Pipeline -*-
+// -*- == -*-
+// -*- Comments.Translator(processor = Composite(Comments.Previous(), Comments.Grouper())) -*-
+
+// group documentation
+// @group first group {
+
+// a class
+struct Foo
+{
+  int first;  //< first comment
+  int second; //< second comment
+  // a nested class
+  struct Bar
+  {
+    int third; //< third comment
+  };
+};
+
+enum Enum
+{
+  ONE,  //< ONE comment
+  TWO,  //< TWO comment
+  THREE //< THREE comment
+};
+// }
+
+// a function
+void test(int);
+int last; //< last comment
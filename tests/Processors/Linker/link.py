@@ -0,0 +1,29 @@
+from Synopsis.Processor import Processor, Composite, Parameter, Error
+from Synopsis.Parsers import Cxx
+from Synopsis.Processors import Linker
+from Synopsis.Formatters import Dump
+from Synopsis import IR
+
+class Link(Processor):
+   """Link the input with the Python linker. If the native linker is
+   available, link it with that as well, and check that both agree."""
+
+   base_path = Parameter('', 'path prefix to strip off of input file names')
+   linker = Parameter({}, 'keyword arguments for the Linker')
+
+   def process(self, ir, **kwds):
+
+      self.set_parameters(kwds)
+      outputs = [(False, self.output)]
+      if Linker().is_native():
+         outputs.append((True, self.output + '.native'))
+      for native, output in outputs:
+         link = Composite(Cxx.Parser(base_path = self.base_path),
+                          Linker(native = native, **self.linker),
+                          Dump.Formatter(show_ids = False, stylesheet = None))
+         link.process(IR.IR(), input = self.input, output = output)
+      for native, output in outputs[1:]:
+         if open(output).read() != open(self.output).read():
+            raise Error('the native linker output %s differs from %s'
+                        %(output, self.output))
+      return ir
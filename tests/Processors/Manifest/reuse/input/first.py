@@ -0,0 +1,4 @@
+"""A module."""
+
+def function():
+    """A function."""
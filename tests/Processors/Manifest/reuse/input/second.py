@@ -0,0 +1,4 @@
+"""Another module."""
+
+class Class:
+    """A class."""
@@ -20,6 +20,10 @@ class Database(database.Database):
 
    arguments = [TextField(name="srcdir")]
 
+   directory_suites = ['Processors.AccessRestrictor', 'Processors.Linker',
+                       'Processors.Manifest', 'Synopsis']
+   """Suites whose tests are directories, each holding its own script."""
+
    def __init__(self, path, arguments):
 
       arguments["modifiable"] = "false"
@@ -50,6 +54,9 @@ class Database(database.Database):
       return filter(lambda x: os.path.isdir(os.path.join(path, x)),
                     dircache.listdir(path))
 
+   def is_directory_suite(self, id):
+      return [s for s in self.directory_suites if id.startswith(s)] != []
+
    def GetSubdirectories(self, dir):
 
       if not os.path.isdir(self.get_src_path(dir)):
@@ -59,9 +66,9 @@ class Database(database.Database):
 
       if not dir:
 
-         return ['Cxx', 'Parsers', 'Processors']
+         return ['Cxx', 'Parsers', 'Processors', 'Synopsis']
 
-      elif dir.startswith('Processors.Linker'):
+      elif self.is_directory_suite(dir):
 
          # just make sure this isn't a test itself...
          if os.path.exists(os.path.join(self.get_build_path(dir), 'synopsis.py')):
@@ -100,7 +107,7 @@ class Database(database.Database):
 
       tests = []
 
-      if dir.startswith('Processors.Linker'):
+      if self.is_directory_suite(dir):
 
          # just make sure this isn't a test itself...
          if os.path.exists(os.path.join(self.get_build_path(dir), 'synopsis.py')):
@@ -188,7 +195,7 @@ class Database(database.Database):
 
       if not id: raise NoSuchTestError, id
          
-      if id.startswith('Processors.Linker'): return self.make_linker_test(id)
+      if self.is_directory_suite(id): return self.make_directory_test(id)
       elif id.startswith('Cxx-API'): return self.make_api_test(id)
       elif id.startswith('Cxx'): return self.make_opencxx_test(id)
       else: return self.make_processor_test(id)
@@ -211,7 +218,7 @@ class Database(database.Database):
 
       output = os.path.join(*components[:-1] + ['output', components[-1] + '.xml'])
       expected = os.path.join(dirname, 'expected', components[-1] + '.xml')
-      if components[0] == 'Processors' and components[1] != 'Linker':
+      if components[0] == 'Processors':
          synopsis = os.path.join('Processors', 'synopsis.py')
       else:
          synopsis = os.path.join(*components[:-1] + ['synopsis.py'])
@@ -225,9 +232,10 @@ class Database(database.Database):
       
       return TestDescriptor(self, id, 'synopsis_test.ProcessorTest', parameters)
 
-   def make_linker_test(self, id):
-      """A test id 'a.b.c' corresponds to an input directory
-      'a/b/c/input containing files to be linked together.
+   def make_directory_test(self, id):
+      """A test id 'a.b.c' corresponds to an (optional) input directory
+      'a/b/c/input containing files to be processed together
+      by the script 'a/b/c/synopsis.py'.
       Create a ProcessorTest if that directory exists,
       and throw NoSuchTestError otherwise."""
 
@@ -238,7 +246,10 @@ class Database(database.Database):
 
       parameters = {}
       parameters['srcdir'] = self.srcdir
-      parameters['input'] = [os.path.join(dirname, x) for x in dircache.listdir(dirname) if x != '.svn']
+      if os.path.isdir(dirname):
+         parameters['input'] = [os.path.join(dirname, x) for x in dircache.listdir(dirname) if x != '.svn']
+      else:
+         parameters['input'] = []
       parameters['output'] = os.path.join(*id.split('.') + ['output.xml'])
       parameters['expected'] = os.path.join(path, 'expected.xml')
       parameters['synopsis'] = os.path.join(*id.split('.') + ['synopsis.py'])